@@ -0,0 +1,294 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/* Stress benchmark for large scenes. Converts synthetic scenes of doubling
+ * size, half of them a single deep chain of nodes and half a wide fan of
+ * small meshes, and fails if the time per node grows by more than the
+ * allowed factor, with both 32-bit and size_t indices. The chain is deep
+ * enough to overflow the stack of a recursive traversal.
+ *
+ * Scenes with more than 2^32 vertices need tens of gigabytes, so the 32-bit
+ * limit is checked with a mesh that only claims that many vertices; it must
+ * be rejected before they are read.
+ */
+#include "modelheader_generator.hh"
+#include <assimp/scene.h>
+#include <chrono>
+#include <climits>
+#include <sstream>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/* Counts the output instead of storing it */
+class null_buffer: public std::streambuf
+{
+public:
+    size_t size = 0;
+
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override
+    {
+        size += n;
+        return n;
+    }
+
+    int overflow(int c) override
+    {
+        size++;
+        return c;
+    }
+};
+
+void add_children(aiNode* parent, const std::vector<aiNode*>& children)
+{
+    parent->mNumChildren = children.size();
+    parent->mChildren = new aiNode*[children.size()];
+    for(unsigned i = 0; i < children.size(); ++i)
+    {
+        children[i]->mParent = parent;
+        parent->mChildren[i] = children[i];
+    }
+}
+
+aiNode* make_node(unsigned index)
+{
+    aiNode* node = new aiNode;
+    node->mName.Set("node" + std::to_string(index));
+    node->mTransformation.a4 = 1.0f;
+    return node;
+}
+
+aiMesh* make_triangle(unsigned index)
+{
+    aiMesh* mesh = new aiMesh;
+    mesh->mName.Set("mesh" + std::to_string(index));
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    mesh->mMaterialIndex = 0;
+    mesh->mNumVertices = 3;
+    mesh->mVertices = new aiVector3D[3];
+    mesh->mNormals = new aiVector3D[3];
+    for(unsigned i = 0; i < 3; ++i)
+    {
+        mesh->mVertices[i] = aiVector3D(index + (i == 1), 0, i == 2);
+        mesh->mNormals[i] = aiVector3D(0, 1, 0);
+    }
+    mesh->mNumFaces = 1;
+    mesh->mFaces = new aiFace[1];
+    mesh->mFaces[0].mNumIndices = 3;
+    mesh->mFaces[0].mIndices = new unsigned[3]{0, 1, 2};
+    return mesh;
+}
+
+aiScene* make_scene(unsigned node_count)
+{
+    aiScene* scene = new aiScene;
+    scene->mNumMaterials = 1;
+    scene->mMaterials = new aiMaterial*[1]{new aiMaterial};
+
+    unsigned chain_length = node_count / 2;
+    unsigned fan_width = node_count - chain_length - 1;
+
+    scene->mNumMeshes = fan_width;
+    scene->mMeshes = new aiMesh*[fan_width];
+
+    aiNode* root = make_node(0);
+    std::vector<aiNode*> fan;
+    for(unsigned i = 0; i < fan_width; ++i)
+    {
+        scene->mMeshes[i] = make_triangle(i);
+        aiNode* node = make_node(1 + i);
+        node->mNumMeshes = 1;
+        node->mMeshes = new unsigned[1]{i};
+        fan.push_back(node);
+    }
+
+    aiNode* chain = make_node(1 + fan_width);
+    fan.push_back(chain);
+    add_children(root, fan);
+
+    for(unsigned i = 1; i < chain_length; ++i)
+    {
+        aiNode* node = make_node(1 + fan_width + i);
+        add_children(chain, {node});
+        chain = node;
+    }
+
+    scene->mRootNode = root;
+    return scene;
+}
+
+/* A triangle followed by a mesh whose vertex count pushes the total past what
+ * 32-bit indices can address.
+ */
+aiScene* make_oversized_scene()
+{
+    aiScene* scene = new aiScene;
+    scene->mNumMaterials = 1;
+    scene->mMaterials = new aiMaterial*[1]{new aiMaterial};
+    scene->mNumMeshes = 2;
+    scene->mMeshes = new aiMesh*[2]{make_triangle(0), make_triangle(1)};
+    scene->mMeshes[1]->mNumVertices = UINT_MAX - 1;
+
+    aiNode* root = make_node(0);
+    root->mNumMeshes = 2;
+    root->mMeshes = new unsigned[2]{0, 1};
+    scene->mRootNode = root;
+    return scene;
+}
+
+bool check_index_modes()
+{
+    modelheader::options options;
+    options.source_name = "stress";
+
+    aiScene* scene = make_oversized_scene();
+    std::ostringstream out, log;
+    bool ok = modelheader::convert(options, scene, out, log);
+    scene->mMeshes[1]->mNumVertices = 3;
+    delete scene;
+    if(ok || !out.str().empty())
+    {
+        std::cerr << "More than 2^32 - 1 vertices were not rejected cleanly."
+            << std::endl;
+        return false;
+    }
+
+    scene = make_scene(16);
+    options.size_t_indices = true;
+    options.strip = true;
+    out.str("");
+    ok = modelheader::convert(options, scene, out, log);
+    delete scene;
+    std::string header = out.str();
+    if(
+        !ok ||
+        header.find("size_t stress_indices[]") == std::string::npos ||
+        header.find("(size_t)-1") == std::string::npos
+    ){
+        std::cerr << "size_t indices were not written." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* aiNode's destructor recurses into its children, so the deep chain has to
+ * be torn down one node at a time.
+ */
+void free_scene(aiScene* scene)
+{
+    std::vector<aiNode*> stack{scene->mRootNode};
+    while(!stack.empty())
+    {
+        aiNode* node = stack.back();
+        stack.pop_back();
+        for(unsigned i = 0; i < node->mNumChildren; ++i)
+            stack.push_back(node->mChildren[i]);
+        node->mNumChildren = 0;
+        delete node;
+    }
+    scene->mRootNode = nullptr;
+    delete scene;
+}
+
+/* Returns false if the time per node grows by more than max_ratio over
+ * scenes of base_count << 0 to base_count << (steps - 1) nodes.
+ */
+bool check_scaling(const modelheader::options& options, unsigned base_count)
+{
+    const unsigned steps = 4;
+    const unsigned repeats = 3;
+    const double max_ratio = 2.0;
+
+    double min_ns = 0, max_ns = 0;
+    for(unsigned step = 0; step < steps; ++step)
+    {
+        unsigned node_count = base_count << step;
+        aiScene* scene = make_scene(node_count);
+
+        double best = 0;
+        size_t size = 0;
+        for(unsigned r = 0; r < repeats; ++r)
+        {
+            null_buffer out_buffer, log_buffer;
+            std::ostream out(&out_buffer), log(&log_buffer);
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = modelheader::convert(options, scene, out, log);
+            auto end = std::chrono::steady_clock::now();
+
+            if(!ok)
+            {
+                std::cerr << "Conversion of " << node_count
+                    << " nodes failed." << std::endl;
+                free_scene(scene);
+                return false;
+            }
+            double ns = std::chrono::duration<double, std::nano>(
+                end - start
+            ).count();
+            if(r == 0 || ns < best) best = ns;
+            size = out_buffer.size;
+        }
+        free_scene(scene);
+
+        double per_node = best / node_count;
+        if(step == 0 || per_node < min_ns) min_ns = per_node;
+        if(step == 0 || per_node > max_ns) max_ns = per_node;
+
+        std::cout << node_count << " nodes: " << best * 1e-6 << " ms, "
+            << per_node << " ns/node, " << size << " bytes"
+            << std::endl;
+    }
+
+    double ratio = max_ns / min_ns;
+    std::cout << "Per-node time ratio: " << ratio << " (limit "
+        << max_ratio << ")" << std::endl;
+    return ratio <= max_ratio;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    unsigned base_count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 25000;
+
+    if(!check_index_modes()) return 1;
+
+    modelheader::options options;
+    options.source_name = "stress";
+
+    bool ok = true;
+    for(bool size_t_indices: {false, true})
+    {
+        options.size_t_indices = size_t_indices;
+        std::cout << (size_t_indices ? "size_t" : "32-bit") << " indices:"
+            << std::endl;
+        ok &= check_scaling(options, base_count);
+    }
+    return ok ? 0 : 1;
+}
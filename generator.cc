@@ -24,123 +24,133 @@ SOFTWARE.
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <string>
 #include <algorithm>
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/Importer.hpp>
+#include "modelheader_generator.hh"
 
-void print_help(const char* name)
+namespace
 {
-    std::cerr
-        << "Usage: " << name << " [-p] [-dnt] [-m] [-n name_prefix] model_file"
-        << std::endl
-        << "-p disables pre-transformed primitives." << std::endl
-        << "-m disables material, mesh and node information." << std::endl
-        << "-d deletes parts of vertex data. 'n' removes normals, "
-        << "'t' removes UV coordinates." << std::endl
-        << "-n sets the default name prefix for the model." << std::endl;
-}
 
-struct
+const char* cpp17_condition =
+    "#if defined(__cplusplus) && __cplusplus >= 201703L\n";
+
+struct aabb;
+
+/* The node hierarchy flattened in pre-order, so that parents precede their
+ * children. It is built with an explicit stack, as scenes can be far too deep
+ * for recursion.
+ */
+struct node_table
+{
+    explicit node_table(aiNode* root);
+
+    /* Returns the first node with the given name in pre-order, like
+     * aiNode::FindNode(), or UINT_MAX if there is none.
+     */
+    unsigned find(const aiString& name) const;
+
+    std::vector<aiNode*> nodes;
+    /* UINT_MAX for the root */
+    std::vector<unsigned> parent;
+    /* The children of node i are children[child_offset[i]] up to
+     * children[child_offset[i+1]].
+     */
+    std::vector<unsigned> child_offset;
+    std::vector<unsigned> children;
+    std::unordered_map<std::string, unsigned> by_name;
+};
+
+/* Writes the header of a single model. The member functions read the
+ * options of this conversion and write to its streams, so that separate
+ * conversions share no state.
+ */
+class writer
 {
-    std::string input_file;
-    std::string name_prefix;
+public:
+    writer(
+        const modelheader::options& opts,
+        std::ostream& out,
+        std::ostream& log
+    );
+
+    /* Writes nothing if the scene cannot be converted */
+    bool write_scene(const aiScene* scene);
+    void write_prologue();
+
+private:
+    void write_preamble();
+
+    void write_typed_array(
+        const char* c_type,
+        const char* name,
+        const char* cpp_type,
+        const char* cpp_name,
+        const std::string& content
+    );
+
+    void write_nodes(
+        const node_table& table,
+        const std::vector<unsigned>& mesh_key,
+        std::stringstream& nodes,
+        std::stringstream& private_declaration,
+        std::stringstream& private_content
+    );
+
+    void write_bounds_soa(
+        const std::string& name,
+        const std::vector<aabb>& bounds,
+        unsigned stride
+    );
+
+    void write_animations(
+        const aiScene* scene,
+        const node_table& table,
+        unsigned& animation_count
+    );
+
+    void write_cpp_traits(
+        bool position_present,
+        bool normal_present,
+        bool uv0_present,
+        bool skin_present
+    );
+
+    modelheader::options options;
     std::string uppercase_name_prefix;
-    bool pretransform = true;
-    bool delete_normal = false;
-    bool delete_uv = false;
-    bool disable_info = false;
-} options;
+    std::ostream& out;
+    std::ostream& log;
+};
 
-bool parse_args(char** argv)
+writer::writer(
+    const modelheader::options& opts,
+    std::ostream& out,
+    std::ostream& log
+): options(opts), out(out), log(log)
 {
-    const char* name = *argv++;
-    bool skip_flags = false;
-    unsigned parameter_count = 0;
-    while(*argv)
+    if(options.name_prefix.empty())
     {
-        const char* arg = *argv;
-        if(!skip_flags && arg[0] == '-')
-        {
-            if(arg[1] == '-')
-            {
-                if(arg[2] == 0) skip_flags = true;
-                else if(!strcmp(arg+2, "help")) goto fail;
-                else if(!strcmp(arg+2, "no-pretransform"))
-                {
-                    options.pretransform = false;
-                }
-                else
-                {
-                    std::cerr << "Unknown long flag " << arg+2 << std::endl;
-                    goto fail;
-                }
-            }
-            else if(arg[1] == 'p' && arg[2] == 0)
-            {
-                options.pretransform = false;
-            }
-            else if(arg[1] == 'm' && arg[2] == 0)
-            {
-                options.disable_info = true;
-            }
-            else if(arg[1] == 'n' && arg[2] == 0)
-            {
-                argv++;
-                if(!*argv)
-                {
-                    std::cerr << "Missing name prefix" << std::endl;
-                    goto fail;
-                }
-                options.name_prefix = *argv;
-            }
-            else if(arg[1] == 'd')
-            {
-                for(unsigned i = 2; arg[i] != 0; ++i)
-                {
-                    switch(arg[i]) 
-                    {
-                    case 'n':
-                        options.delete_normal = true;
-                        break;
-                    case 't':
-                        options.delete_uv = true;
-                        break;
-                    default:
-                        std::cerr << "Unknown vertex attribute \""
-                            << arg[i] << "\"" << std::endl;
-                        goto fail;
-                    }
-                }
-            }
-            else
-            {
-                std::cerr << "Unknown flag " << arg+1 << std::endl;
-                goto fail;
-            }
-        }
-        else
-        {
-            if(parameter_count == 0)
-            {
-                options.input_file = arg;
-                parameter_count++;
-            }
-            else
-            {
-                std::cerr << "Too many parameters." << std::endl;
-                goto fail;
-            }
-        }
-        argv++;
+        options.name_prefix = modelheader::default_name_prefix(
+            options.source_name
+        );
     }
-    if(parameter_count == 0) goto fail;
-    return true;
-fail:
-    print_help(name);
-    return false;
+
+    uppercase_name_prefix = options.name_prefix;
+    std::transform(
+        options.name_prefix.begin(),
+        options.name_prefix.end(),
+        uppercase_name_prefix.begin(),
+        toupper
+    );
 }
 
 std::string escape_string(const std::string& str)
@@ -163,25 +173,35 @@ std::string escape_string(const std::string& str)
     return out.str();
 }
 
-void write_preamble()
+void writer::write_preamble()
 {
-    std::cout <<
-        "/* Automatically generated header from file \"" << options.input_file
+    out <<
+        "/* Automatically generated header from file \"" << options.source_name
         << "\" */\n"
-        "#ifndef MODELHEADER_MODEL_" << options.uppercase_name_prefix << "_H\n"
-        "#define MODELHEADER_MODEL_" << options.uppercase_name_prefix << "_H\n"
-        << (options.disable_info ? "" : "#include <stddef.h>\n") <<
+        "#ifndef MODELHEADER_MODEL_" << uppercase_name_prefix << "_H\n"
+        "#define MODELHEADER_MODEL_" << uppercase_name_prefix << "_H\n"
+        << (options.disable_info && !options.size_t_indices ?
+            "" : "#include <stddef.h>\n") <<
         "#ifndef MODELHEADER_TYPES_DECLARED\n"
         "#define MODELHEADER_TYPES_DECLARED\n"
         "#if __cplusplus >= 201103L\n"
         "#define MODELHEADER_CONST constexpr const\n"
         "#else\n"
         "#define MODELHEADER_CONST const\n"
-        "#endif\n";
+        "#endif\n"
+        "#if __cplusplus >= 201103L\n"
+        "#define MODELHEADER_ALIGNAS(n) alignas(n)\n"
+        "#elif __STDC_VERSION__ >= 201112L\n"
+        "#define MODELHEADER_ALIGNAS(n) _Alignas(n)\n"
+        "#else\n"
+        "#define MODELHEADER_ALIGNAS(n)\n"
+        "#endif\n"
+        "#define MODELHEADER_TRIANGLES 0\n"
+        "#define MODELHEADER_TRIANGLE_STRIP 1\n";
 
     if(!options.disable_info)
     {
-        std::cout << "\n"
+        out << "\n"
             "struct modelheader_material\n"
             "{\n"
             "    const char* name;\n"
@@ -193,8 +213,13 @@ void write_preamble()
             "{\n"
             "    const char* name;\n"
             "    const struct modelheader_material* material;\n"
-            "    unsigned start_index;\n"
-            "    unsigned size;\n"
+            "    size_t start_index;\n"
+            "    size_t size;\n"
+            "    unsigned primitive;\n"
+            "\n"
+            "    float aabb_min[3];\n"
+            "    float aabb_max[3];\n"
+            "    float bounding_sphere[4];\n"
             "};\n"
             "\n"
             "struct modelheader_node\n"
@@ -209,122 +234,1121 @@ void write_preamble()
             "    float transform[16];\n"
             "};\n\n";
     }
-    std::cout << "#endif\n\n";
+    out << "#endif\n\n";
+
+    if(options.animations)
+    {
+        out <<
+            "#ifndef MODELHEADER_ANIMATION_TYPES_DECLARED\n"
+            "#define MODELHEADER_ANIMATION_TYPES_DECLARED\n"
+            "\n"
+            "struct modelheader_joint\n"
+            "{\n"
+            "    const struct modelheader_node* node;\n"
+            "    float inverse_bind[16];\n"
+            "};\n"
+            "\n"
+            "struct modelheader_channel\n"
+            "{\n"
+            "    unsigned node;\n"
+            "\n"
+            "    unsigned position_count;\n"
+            "    const float* position_times;\n"
+            "    const unsigned short* positions;\n"
+            "    float position_bias[3];\n"
+            "    float position_scale[3];\n"
+            "\n"
+            "    unsigned rotation_count;\n"
+            "    const float* rotation_times;\n"
+            "    const unsigned short* rotations;\n"
+            "\n"
+            "    unsigned scaling_count;\n"
+            "    const float* scaling_times;\n"
+            "    const unsigned short* scalings;\n"
+            "    float scaling_bias[3];\n"
+            "    float scaling_scale[3];\n"
+            "};\n"
+            "\n"
+            "struct modelheader_animation\n"
+            "{\n"
+            "    const char* name;\n"
+            "    float duration;\n"
+            "    const struct modelheader_channel* channels;\n"
+            "    unsigned channel_count;\n"
+            "};\n"
+            "\n"
+            "#endif\n\n";
+    }
+
+    if(options.cpp)
+    {
+        out << cpp17_condition <<
+            "#ifndef MODELHEADER_CPP_TYPES_DECLARED\n"
+            "#define MODELHEADER_CPP_TYPES_DECLARED\n"
+            "#include <cstddef>\n"
+            "\n"
+            "namespace modelheader\n"
+            "{\n"
+            "\n"
+            "template<typename T>\n"
+            "struct span\n"
+            "{\n"
+            "    const T* ptr;\n"
+            "    std::size_t count;\n"
+            "\n"
+            "    constexpr const T* data() const { return ptr; }\n"
+            "    constexpr std::size_t size() const { return count; }\n"
+            "    constexpr const T* begin() const { return ptr; }\n"
+            "    constexpr const T* end() const { return ptr + count; }\n"
+            "    constexpr const T& operator[](std::size_t i) const\n"
+            "    {\n"
+            "        return ptr[i];\n"
+            "    }\n"
+            "};\n"
+            "\n"
+            "enum attribute: unsigned\n"
+            "{\n"
+            "    POSITION = 1 << 0,\n"
+            "    NORMAL = 1 << 1,\n"
+            "    UV0 = 1 << 2,\n"
+            "    SKIN = 1 << 3\n"
+            "};\n"
+            "\n"
+            "/* Specialized for the tag type of each model, <prefix>_model. */\n"
+            "template<typename Model>\n"
+            "struct model_traits;\n"
+            "\n"
+            "}\n"
+            "#endif\n"
+            "#endif\n\n";
+    }
+}
+
+/* Writes an array that C++17 also gets as an array of the per-model vertex
+ * struct. Both are instantiated from the same brace-elided initializer, so
+ * the C name stays a real array in every language mode.
+ */
+void writer::write_typed_array(
+    const char* c_type,
+    const char* name,
+    const char* cpp_type,
+    const char* cpp_name,
+    const std::string& content
+){
+    const std::string& prefix = options.name_prefix;
+    if(!options.cpp)
+    {
+        out
+            << "static MODELHEADER_CONST " << c_type << " "
+            << prefix << "_" << name << "[] = {\n"
+            << "    " << content << "\n};\n\n";
+        return;
+    }
+
+    std::string macro = "MODELHEADER_" + uppercase_name_prefix + "_" + name;
+    std::transform(macro.begin(), macro.end(), macro.begin(), toupper);
+    macro += "_INITIALIZER";
+
+    out
+        << "#define " << macro << " \\\n"
+        << "    " << content << "\n"
+        << "static MODELHEADER_CONST " << c_type << " "
+        << prefix << "_" << name << "[] = {" << macro << "};\n"
+        << cpp17_condition
+        << "static MODELHEADER_CONST " << prefix << "_" << cpp_type << " "
+        << prefix << "_" << cpp_name << "[] = {" << macro << "};\n"
+        << "#endif\n"
+        << "#undef " << macro << "\n\n";
 }
 
-void write_prologue()
+void writer::write_prologue()
 {
-    std::cout <<
+    out <<
         "#endif\n";
 }
 
-void write_node(
-    unsigned& node_count,
-    const std::map<unsigned, unsigned>& mesh_key,
-    const std::map<aiNode*, unsigned>& node_key,
-    aiNode* node,
+void writer::write_nodes(
+    const node_table& table,
+    const std::vector<unsigned>& mesh_key,
     std::stringstream& nodes,
     std::stringstream& private_declaration,
     std::stringstream& private_content
 ){
-    if(!node) return;
+    for(unsigned index = 0; index < table.nodes.size(); ++index)
+    {
+        aiNode* node = table.nodes[index];
+
+        nodes << "        {";
 
-    unsigned index = node_count++;
+        unsigned mesh_count = 0;
+        for(unsigned i = 0; i < node->mNumMeshes; ++i)
+            if(mesh_key[node->mMeshes[i]] != UINT_MAX) mesh_count++;
 
-    nodes << "        {";
+        if(mesh_count > 0)
+        {
+            private_declaration
+                << "    const struct modelheader_mesh* const meshes_"
+                << index << "[" << mesh_count << "];\n";
 
-    if(node->mNumMeshes > 0)
+            private_content << "    {\n";
+            for(unsigned i = 0; i < node->mNumMeshes; ++i)
+            {
+                unsigned mesh = mesh_key[node->mMeshes[i]];
+                if(mesh == UINT_MAX) continue;
+                private_content
+                    << "        &" << options.name_prefix << "_meshes["
+                    << mesh << "],\n";
+            }
+
+            private_content << "    },\n";
+
+            nodes
+                << options.name_prefix << "_private_data.meshes_" << index
+                << ", " << mesh_count << ", ";
+        }
+        else
+        {
+            nodes << "NULL, 0, ";
+        }
+
+        if(table.parent[index] != UINT_MAX)
+            nodes
+                << "&" << options.name_prefix << "_private_data.nodes["
+                << table.parent[index] << "], ";
+        else nodes << "NULL, ";
+
+        unsigned child_begin = table.child_offset[index];
+        unsigned child_end = table.child_offset[index + 1];
+        if(child_end > child_begin)
+        {
+            private_declaration
+                << "    const struct modelheader_node* const children_"
+                << index << "[" << child_end - child_begin << "];\n";
+
+            private_content << "    {\n";
+            for(unsigned i = child_begin; i < child_end; ++i)
+            {
+                private_content
+                    << "        &" << options.name_prefix
+                    << "_private_data.nodes[" << table.children[i] << "],\n";
+            }
+
+            private_content << "    },\n";
+            nodes
+                << options.name_prefix << "_private_data.children_" << index
+                << ", " << child_end - child_begin << ", ";
+        }
+        else
+        {
+            nodes << "NULL, 0, ";
+        }
+
+        nodes << "{";
+        for(unsigned i = 0; i < 4*4; ++i)
+        {
+            nodes << node->mTransformation[i/4][i%4] << ",";
+        }
+        nodes << "}},\n";
+    }
+}
+
+/* Rounds to the nearest float that is not above or below v, so that bounds
+ * computed in double stay conservative.
+ */
+float round_down(double v)
+{
+    float f = v;
+    return f > v ? std::nextafter(f, -std::numeric_limits<float>::max()) : f;
+}
+
+float round_up(double v)
+{
+    float f = v;
+    return f < v ? std::nextafter(f, std::numeric_limits<float>::max()) : f;
+}
+
+struct aabb
+{
+    aiVector3D min = aiVector3D(std::numeric_limits<float>::max());
+    aiVector3D max = aiVector3D(-std::numeric_limits<float>::max());
+
+    bool empty() const { return min.x > max.x; }
+
+    void add(const aiVector3D& p)
+    {
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            min[i] = std::min(min[i], p[i]);
+            max[i] = std::max(max[i], p[i]);
+        }
+    }
+
+    void add(const aabb& other)
     {
-        private_declaration
-            << "    const struct modelheader_mesh* const meshes_"
-            << index << "[" << node->mNumMeshes << "];\n";
+        if(other.empty()) return;
+        add(other.min);
+        add(other.max);
+    }
 
-        private_content << "    {\n";
-        for(unsigned i = 0; i < node->mNumMeshes; ++i)
+    /* Conservative bounds of this box after an affine transform */
+    aabb transform(const aiMatrix4x4& m) const
+    {
+        if(empty()) return *this;
+        aabb result;
+        for(unsigned i = 0; i < 3; ++i)
         {
-            private_content
-                << "        &" << options.name_prefix << "_meshes["
-                << mesh_key.at(node->mMeshes[i]) << "],\n";
+            double lo = m[i][3], hi = m[i][3];
+            for(unsigned j = 0; j < 3; ++j)
+            {
+                double a = (double)m[i][j] * min[j];
+                double b = (double)m[i][j] * max[j];
+                lo += std::min(a, b);
+                hi += std::max(a, b);
+            }
+            result.min[i] = round_down(lo);
+            result.max[i] = round_up(hi);
         }
+        return result;
+    }
+};
 
-        private_content << "    },\n";
+/* Space-filling curve keys use 21 bits per axis, so that three axes fit in a
+ * 64-bit key.
+ */
+const unsigned curve_bits = 21;
 
-        nodes
-            << options.name_prefix << "_private_data.meshes_" << index << ", "
-            << node->mNumMeshes << ", ";
+/* Inserts two zero bits between each of the low 21 bits of v */
+uint64_t spread_bits(uint64_t v)
+{
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFF;
+    v = (v | v << 16) & 0x1F0000FF0000FF;
+    v = (v | v << 8) & 0x100F00F00F00F00F;
+    v = (v | v << 4) & 0x10C30C30C30C30C3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+uint64_t morton_key(unsigned x, unsigned y, unsigned z)
+{
+    return spread_bits(x) << 2 | spread_bits(y) << 1 | spread_bits(z);
+}
+
+/* Skilling's transform from "Programming the Hilbert curve" (2004). Rotates
+ * and reflects the coordinates so that interleaving their bits gives the
+ * distance along the Hilbert curve.
+ */
+uint64_t hilbert_key(unsigned x, unsigned y, unsigned z)
+{
+    unsigned X[3] = {x, y, z};
+    for(unsigned q = 1u << (curve_bits - 1); q > 1; q >>= 1)
+    {
+        unsigned p = q - 1;
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            if(X[i] & q) X[0] ^= p;
+            else
+            {
+                unsigned t = (X[0] ^ X[i]) & p;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
     }
-    else
+
+    /* Gray encode */
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    unsigned t = 0;
+    for(unsigned q = 1u << (curve_bits - 1); q > 1; q >>= 1)
+        if(X[2] & q) t ^= q - 1;
+    for(unsigned i = 0; i < 3; ++i) X[i] ^= t;
+
+    return morton_key(X[0], X[1], X[2]);
+}
+
+/* Returns the indices of the given points in the order they are visited by a
+ * Morton or Hilbert curve over their bounding box. Points with the same key
+ * keep their original order.
+ */
+std::vector<unsigned> spatial_order(
+    const std::vector<aiVector3D>& points,
+    bool hilbert
+){
+    aabb bounds;
+    for(const aiVector3D& p: points) bounds.add(p);
+
+    /* Same scale on every axis, so that cells stay cubes */
+    float extent = 0;
+    for(unsigned i = 0; i < 3; ++i)
+        extent = std::max(extent, bounds.max[i] - bounds.min[i]);
+    float scale = extent > 0 ? ((1u << curve_bits) - 1) / extent : 0;
+
+    std::vector<uint64_t> keys(points.size());
+    for(unsigned i = 0; i < points.size(); ++i)
     {
-        nodes << "NULL, 0, ";
+        unsigned q[3];
+        for(unsigned j = 0; j < 3; ++j)
+            q[j] = std::min(
+                (points[i][j] - bounds.min[j]) * scale,
+                float((1u << curve_bits) - 1)
+            );
+        keys[i] = hilbert ?
+            hilbert_key(q[0], q[1], q[2]) : morton_key(q[0], q[1], q[2]);
     }
 
-    if(node->mParent)
-        nodes
-            << "&" << options.name_prefix << "_private_data.nodes["
-            << node_key.at(node->mParent) << "], ";
-    else nodes << "NULL, ";
+    std::vector<unsigned> order(points.size());
+    for(unsigned i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(
+        order.begin(),
+        order.end(),
+        [&](unsigned a, unsigned b){ return keys[a] < keys[b]; }
+    );
+    return order;
+}
 
-    if(node->mNumChildren > 0)
+/* Computes the bounds of the subtree of each node, both in the node's own
+ * coordinate system and in the model's coordinate system.
+ */
+void compute_node_bounds(
+    const node_table& table,
+    const std::vector<unsigned>& mesh_key,
+    const std::vector<aabb>& mesh_bounds,
+    std::vector<aabb>& local_bounds,
+    std::vector<aabb>& world_bounds
+){
+    unsigned node_count = table.nodes.size();
+    std::vector<aiMatrix4x4> transforms(node_count);
+    for(unsigned i = 0; i < node_count; ++i)
     {
-        private_declaration
-            << "    const struct modelheader_node* const children_"
-            << index << "[" << node->mNumChildren << "];\n";
+        const aiMatrix4x4& local = table.nodes[i]->mTransformation;
+        unsigned parent = table.parent[i];
+        transforms[i] = parent == UINT_MAX ? local : transforms[parent] * local;
+    }
 
-        private_content << "    {\n";
-        for(unsigned i = 0; i < node->mNumChildren; ++i)
+    /* Children come after their parents, so walking backwards finishes each
+     * subtree before it is added to its parent.
+     */
+    local_bounds.assign(node_count, aabb());
+    world_bounds.assign(node_count, aabb());
+    for(unsigned i = node_count; i-- > 0;)
+    {
+        aiNode* node = table.nodes[i];
+        aabb& local = local_bounds[i];
+        for(unsigned j = 0; j < node->mNumMeshes; ++j)
         {
-            private_content
-                << "        &" << options.name_prefix << "_private_data.nodes["
-                << node_key.at(node->mChildren[i]) << "],\n";
+            unsigned mesh = mesh_key[node->mMeshes[j]];
+            if(mesh != UINT_MAX) local.add(mesh_bounds[mesh]);
         }
 
-        private_content << "    },\n";
-        nodes
-            << options.name_prefix << "_private_data.children_" << index << ", "
-            << node->mNumChildren << ", ";
+        world_bounds[i] = local.transform(transforms[i]);
+        if(table.parent[i] != UINT_MAX)
+        {
+            local_bounds[table.parent[i]].add(
+                local.transform(node->mTransformation)
+            );
+        }
     }
-    else
+}
+
+/* Writes bounds as six rows of min x, y, z and max x, y, z, each padded to
+ * stride entries with empty boxes so that they can be loaded in SIMD-sized
+ * chunks.
+ */
+void writer::write_bounds_soa(
+    const std::string& name,
+    const std::vector<aabb>& bounds,
+    unsigned stride
+){
+    std::streamsize precision = out.precision(
+        std::numeric_limits<float>::max_digits10
+    );
+    out
+        << "MODELHEADER_ALIGNAS(32) static MODELHEADER_CONST float "
+        << options.name_prefix << "_" << name << "[] = {\n";
+    for(unsigned row = 0; row < 6; ++row)
+    {
+        out << "    ";
+        for(unsigned i = 0; i < stride; ++i)
+        {
+            aabb box = i < bounds.size() ? bounds[i] : aabb();
+            out << (row < 3 ? box.min[row] : box.max[row-3]) << ",";
+        }
+        out << "\n";
+    }
+    out << "};\n";
+    out.precision(precision);
+}
+
+node_table::node_table(aiNode* root)
+{
+    std::vector<std::pair<aiNode*, unsigned>> stack;
+    if(root) stack.emplace_back(root, UINT_MAX);
+    while(!stack.empty())
+    {
+        aiNode* node = stack.back().first;
+        unsigned parent_index = stack.back().second;
+        stack.pop_back();
+
+        unsigned index = nodes.size();
+        nodes.push_back(node);
+        parent.push_back(parent_index);
+        by_name.emplace(node->mName.C_Str(), index);
+
+        /* Pushed in reverse so that children are visited in order */
+        for(unsigned i = node->mNumChildren; i-- > 0;)
+        {
+            if(node->mChildren[i])
+                stack.emplace_back(node->mChildren[i], index);
+        }
+    }
+
+    /* Siblings are visited in order, so a counting sort by parent gives the
+     * children of each node in their original order.
+     */
+    child_offset.assign(nodes.size() + 1, 0);
+    for(unsigned i = 0; i < nodes.size(); ++i)
+        if(parent[i] != UINT_MAX) child_offset[parent[i] + 1]++;
+    for(unsigned i = 0; i < nodes.size(); ++i)
+        child_offset[i + 1] += child_offset[i];
+
+    std::vector<unsigned> fill(child_offset.begin(), child_offset.end() - 1);
+    children.resize(child_offset.back());
+    for(unsigned i = 0; i < nodes.size(); ++i)
+        if(parent[i] != UINT_MAX) children[fill[parent[i]]++] = i;
+}
+
+unsigned node_table::find(const aiString& name) const
+{
+    auto it = by_name.find(name.C_Str());
+    return it == by_name.end() ? UINT_MAX : it->second;
+}
+
+const unsigned strip_restart_index = 0xFFFFFFFF;
+
+/* Maps a directed edge, packed into 64 bits, to the triangle containing it */
+typedef std::unordered_map<uint64_t, unsigned> edge_map;
+
+uint64_t edge_key(unsigned a, unsigned b)
+{
+    return (uint64_t)a << 32 | b;
+}
+
+/* Grows a strip starting from the given triangle, rotated so that the strip
+ * begins at its rotation:th vertex. Triangles are only taken if their winding
+ * matches the alternating winding of the strip. Triangles claimed by the strip
+ * are marked with stamp.
+ */
+std::vector<unsigned> grow_strip(
+    const std::vector<unsigned>& triangles,
+    const edge_map& edges,
+    std::vector<unsigned>& mark,
+    unsigned stamp,
+    unsigned start,
+    unsigned rotation,
+    std::vector<unsigned>& strip_triangles
+){
+    const unsigned* t = triangles.data() + 3 * (size_t)start;
+    std::vector<unsigned> strip = {
+        t[rotation], t[(rotation+1)%3], t[(rotation+2)%3]
+    };
+    strip_triangles = {start};
+    mark[start] = stamp;
+
+    for(;;)
+    {
+        unsigned p = strip[strip.size()-2];
+        unsigned q = strip.back();
+        /* Odd triangles in a strip are flipped, so the shared edge must be
+         * walked in the opposite direction.
+         */
+        bool odd = strip.size() % 2 == 1;
+        std::pair<unsigned, unsigned> edge = odd ?
+            std::make_pair(q, p) : std::make_pair(p, q);
+
+        auto it = edges.find(edge_key(edge.first, edge.second));
+        if(it == edges.end()) break;
+
+        unsigned next = it->second;
+        if(mark[next] == UINT_MAX || mark[next] == stamp) break;
+
+        const unsigned* n = triangles.data() + 3 * (size_t)next;
+        unsigned e = 0;
+        while(e < 3 && !(n[e] == edge.first && n[(e+1)%3] == edge.second)) e++;
+        if(e == 3) break;
+
+        strip.push_back(n[(e+2)%3]);
+        strip_triangles.push_back(next);
+        mark[next] = stamp;
+    }
+    return strip;
+}
+
+/* Converts a triangle list into a single triangle strip. Separate strips are
+ * joined with strip_restart_index if restart is set, otherwise by degenerate
+ * triangles.
+ */
+std::vector<unsigned> stripify(
+    const std::vector<unsigned>& triangles,
+    bool restart
+){
+    unsigned triangle_count = triangles.size() / 3;
+    edge_map edges;
+    edges.reserve(triangles.size());
+    for(unsigned i = 0; i < triangle_count; ++i)
+    {
+        const unsigned* t = triangles.data() + 3 * (size_t)i;
+        for(unsigned e = 0; e < 3; ++e)
+            edges.emplace(edge_key(t[e], t[(e+1)%3]), i);
+    }
+
+    std::vector<unsigned> mark(triangle_count, 0);
+    std::vector<unsigned> result;
+    std::vector<unsigned> strip_triangles;
+    std::vector<unsigned> best_triangles;
+    unsigned stamp = 0;
+
+    for(unsigned i = 0; i < triangle_count; ++i)
+    {
+        if(mark[i] == UINT_MAX) continue;
+
+        /* Try every rotation of the starting triangle, keep the longest. */
+        std::vector<unsigned> best;
+        for(unsigned r = 0; r < 3; ++r)
+        {
+            std::vector<unsigned> strip = grow_strip(
+                triangles, edges, mark, ++stamp, i, r, strip_triangles
+            );
+            if(strip.size() > best.size())
+            {
+                best.swap(strip);
+                best_triangles.swap(strip_triangles);
+            }
+        }
+        for(unsigned t: best_triangles) mark[t] = UINT_MAX;
+
+        if(!result.empty())
+        {
+            if(restart) result.push_back(strip_restart_index);
+            else
+            {
+                result.push_back(result.back());
+                result.push_back(best[0]);
+                /* Keep the winding by starting each strip at an even index. */
+                if(result.size() % 2 == 1) result.push_back(best[0]);
+            }
+        }
+        result.insert(result.end(), best.begin(), best.end());
+    }
+    return result;
+}
+
+/* Returns the indices of the keys that must be kept so that interpolating
+ * linearly between them stays within tolerance of every original key.
+ */
+template<typename T, typename Lerp, typename Error>
+std::vector<unsigned> reduce_keys(
+    const std::vector<double>& times,
+    const std::vector<T>& values,
+    double tolerance,
+    Lerp lerp,
+    Error error
+){
+    std::vector<unsigned> kept;
+    if(values.empty()) return kept;
+
+    kept.push_back(0);
+    unsigned start = 0;
+    for(unsigned end = 2; end < values.size(); ++end)
+    {
+        double span = times[end] - times[start];
+        bool fits = true;
+        for(unsigned k = start + 1; fits && k < end; ++k)
+        {
+            double t = span > 0 ? (times[k] - times[start]) / span : 0;
+            fits = error(lerp(values[start], values[end], t), values[k])
+                <= tolerance;
+        }
+        if(!fits)
+        {
+            start = end - 1;
+            kept.push_back(start);
+        }
+    }
+    if(values.size() > 1) kept.push_back(values.size() - 1);
+
+    /* Constant tracks only need a single key. */
+    if(kept.size() == 2 && error(values[0], values.back()) <= tolerance)
+        kept.pop_back();
+    return kept;
+}
+
+/* Quantizes vectors to 16-bit unorm values within their bounding box. */
+void quantize_vectors(
+    const std::vector<aiVector3D>& values,
+    float bias[3],
+    float scale[3],
+    std::vector<unsigned short>& keys
+){
+    for(unsigned i = 0; i < 3; ++i)
+    {
+        float lo = values[0][i], hi = values[0][i];
+        for(const aiVector3D& v: values)
+        {
+            lo = std::min(lo, v[i]);
+            hi = std::max(hi, v[i]);
+        }
+        bias[i] = lo;
+        scale[i] = (hi - lo) / 65535.0f;
+    }
+
+    for(const aiVector3D& v: values)
     {
-        nodes << "NULL, 0, ";
+        for(unsigned i = 0; i < 3; ++i)
+        {
+            keys.push_back(
+                scale[i] > 0 ? lround((v[i] - bias[i]) / scale[i]) : 0
+            );
+        }
     }
+}
 
-    nodes << "{";
-    for(unsigned i = 0; i < 4*4; ++i)
+/* Largest distance between a vector and its quantized value, if the vectors
+ * are quantized within the bounding box of the given ones.
+ */
+double vector_quantization_error(const std::vector<aiVector3D>& values)
+{
+    if(values.empty()) return 0;
+    aabb bounds;
+    for(const aiVector3D& v: values) bounds.add(v);
+    double sum = 0;
+    for(unsigned i = 0; i < 3; ++i)
     {
-        nodes << node->mTransformation[i/4][i%4] << ",";
+        double half_step = (bounds.max[i] - bounds.min[i]) / 65535.0 * 0.5;
+        sum += half_step * half_step;
     }
-    nodes << "}},\n";
+    return sqrt(sum);
+}
+
+/* Bound of the angle between a rotation and its quantized value. Each stored
+ * component is off by at most half a step, 1/(32767*sqrt(2)), and the
+ * reconstructed largest component by at most the sum of those three, so the
+ * quaternion moves by at most sqrt(12) times the step. The angle is twice
+ * that.
+ */
+const double rotation_quantization_error =
+    2.0 * sqrt(12.0) / (32767.0 * sqrt(2.0));
+
+/* Quantizes a rotation with the smallest three encoding: the largest
+ * component of the quaternion is dropped and reconstructed from the other
+ * three, which are stored in 15 bits each. The index of the dropped component
+ * is stored in the top bits of the first two values.
+ */
+void quantize_rotation(aiQuaternion q, std::vector<unsigned short>& keys)
+{
+    q.Normalize();
+    float c[4] = {q.x, q.y, q.z, q.w};
+    unsigned largest = 0;
+    for(unsigned i = 1; i < 4; ++i)
+        if(fabs(c[i]) > fabs(c[largest])) largest = i;
 
-    for(unsigned i = 0; i < node->mNumChildren; ++i)
+    float sign = c[largest] < 0 ? -1.0f : 1.0f;
+    unsigned short packed[3];
+    for(unsigned i = 0, j = 0; i < 4; ++i)
     {
-        write_node(
-            node_count,
-            mesh_key,
-            node_key,
-            node->mChildren[i],
-            nodes,
-            private_declaration,
-            private_content
+        if(i == largest) continue;
+        float v = std::clamp(c[i] * sign * (float)sqrt(2.0), -1.0f, 1.0f);
+        packed[j++] = lround((v * 0.5f + 0.5f) * 32767.0f);
+    }
+    packed[0] |= (largest & 1) << 15;
+    packed[1] |= (largest >> 1) << 15;
+    keys.insert(keys.end(), packed, packed + 3);
+}
+
+void write_float_array(std::stringstream& out, const float* values, unsigned n)
+{
+    out << "{";
+    for(unsigned i = 0; i < n; ++i) out << values[i] << ",";
+    out << "}";
+}
+
+void writer::write_animations(
+    const aiScene* scene,
+    const node_table& table,
+    unsigned& animation_count
+){
+    std::stringstream times;
+    std::stringstream keys;
+    std::stringstream channels;
+    std::stringstream animations;
+    unsigned time_count = 0;
+    unsigned key_count = 0;
+    unsigned channel_count = 0;
+
+    /* Key times, track bias and scale, and durations must read back exactly,
+     * or the tolerance no longer holds for what is sampled.
+     */
+    times.precision(std::numeric_limits<float>::max_digits10);
+    channels.precision(std::numeric_limits<float>::max_digits10);
+    animations.precision(std::numeric_limits<float>::max_digits10);
+
+    times
+        << "static MODELHEADER_CONST float "
+        << options.name_prefix << "_animation_times[] = {\n    ";
+    keys
+        << "static MODELHEADER_CONST unsigned short "
+        << options.name_prefix << "_animation_keys[] = {\n    ";
+    channels
+        << "static MODELHEADER_CONST struct modelheader_channel "
+        << options.name_prefix << "_channels[] = {\n";
+    animations
+        << "static MODELHEADER_CONST struct modelheader_animation "
+        << options.name_prefix << "_animations[] = {\n";
+
+    auto lerp_vector = [](const aiVector3D& a, const aiVector3D& b, double t){
+        return a + (b - a) * (float)t;
+    };
+    auto vector_error = [](const aiVector3D& a, const aiVector3D& b){
+        return (double)(a - b).Length();
+    };
+    /* Normalized lerp along the shorter arc, exactly like
+     * modelheader_sample_rotation(), so that the tolerance bounds what the
+     * sampler returns.
+     */
+    auto lerp_rotation = [](const aiQuaternion& a, const aiQuaternion& b, double t){
+        double dot = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+        double s = dot < 0 ? -t : t;
+        aiQuaternion q(
+            a.w * (1.0 - t) + b.w * s,
+            a.x * (1.0 - t) + b.x * s,
+            a.y * (1.0 - t) + b.y * s,
+            a.z * (1.0 - t) + b.z * s
         );
+        q.Normalize();
+        return q;
+    };
+    /* Angle of a * conj(b), from its vector part and w. acos() of the dot
+     * product is useless for the small angles that matter here, as the dot
+     * product rounds to 1 below about 1e-4 radians in float.
+     */
+    auto rotation_error = [](const aiQuaternion& a, const aiQuaternion& b){
+        double w = a.x*b.x + a.y*b.y + a.z*b.z + a.w*b.w;
+        double x = (double)a.x*b.w - (double)a.w*b.x
+            - ((double)a.y*b.z - (double)a.z*b.y);
+        double y = (double)a.y*b.w - (double)a.w*b.y
+            - ((double)a.z*b.x - (double)a.x*b.z);
+        double z = (double)a.z*b.w - (double)a.w*b.z
+            - ((double)a.x*b.y - (double)a.y*b.x);
+        return 2.0 * atan2(sqrt(x*x + y*y + z*z), fabs(w));
+    };
+
+    /* Writes the times of the kept keys and returns a pointer expression to
+     * them.
+     */
+    auto write_times = [&](
+        const std::vector<double>& key_times,
+        const std::vector<unsigned>& kept
+    ){
+        if(kept.empty()) return std::string("NULL");
+        std::string ptr =
+            options.name_prefix + "_animation_times + " +
+            std::to_string(time_count);
+        for(unsigned k: kept) times << (float)key_times[k] << ",";
+        time_count += kept.size();
+        return ptr;
+    };
+    auto write_keys = [&](const std::vector<unsigned short>& packed){
+        if(packed.empty()) return std::string("NULL");
+        std::string ptr =
+            options.name_prefix + "_animation_keys + " +
+            std::to_string(key_count);
+        for(unsigned short k: packed) keys << k << ",";
+        key_count += packed.size();
+        return ptr;
+    };
+
+    unsigned original_keys = 0;
+    unsigned reduced_keys = 0;
+    /* Interpolating between quantized keys is off by at most the
+     * quantization error, so only the rest of the tolerance is left for
+     * dropping keys.
+     */
+    auto reduction_tolerance = [&](const aiString& node, double error){
+        if(error <= options.anim_tolerance)
+            return options.anim_tolerance - error;
+        log << "Quantization alone exceeds the animation tolerance for node "
+            << node.C_Str() << " (error " << error << "), keeping all keys."
+            << std::endl;
+        return 0.0;
+    };
+
+    auto write_vector_track = [&](
+        const aiString& node,
+        const aiVectorKey* in,
+        unsigned count,
+        double ticks_per_second
+    ){
+        std::vector<double> key_times;
+        std::vector<aiVector3D> values;
+        for(unsigned k = 0; k < count; ++k)
+        {
+            key_times.push_back(in[k].mTime / ticks_per_second);
+            values.push_back(in[k].mValue);
+        }
+        std::vector<unsigned> kept = reduce_keys(
+            key_times, values,
+            reduction_tolerance(node, vector_quantization_error(values)),
+            lerp_vector, vector_error
+        );
+        original_keys += count;
+        reduced_keys += kept.size();
+
+        std::vector<aiVector3D> kept_values;
+        for(unsigned k: kept) kept_values.push_back(values[k]);
+
+        float bias[3] = {0, 0, 0};
+        float scale[3] = {0, 0, 0};
+        std::vector<unsigned short> packed;
+        if(!kept.empty()) quantize_vectors(kept_values, bias, scale, packed);
+
+        channels << kept.size() << ", " << write_times(key_times, kept)
+                 << ", " << write_keys(packed) << ", ";
+        write_float_array(channels, bias, 3);
+        channels << ", ";
+        write_float_array(channels, scale, 3);
+    };
+
+    for(unsigned i = 0; i < scene->mNumAnimations; ++i)
+    {
+        aiAnimation* inanim = scene->mAnimations[i];
+        double ticks_per_second =
+            inanim->mTicksPerSecond > 0 ? inanim->mTicksPerSecond : 25.0;
+        unsigned start_channel = channel_count;
+        original_keys = 0;
+        reduced_keys = 0;
+
+        for(unsigned j = 0; j < inanim->mNumChannels; ++j)
+        {
+            aiNodeAnim* inchannel = inanim->mChannels[j];
+            unsigned node = table.find(inchannel->mNodeName);
+            if(node == UINT_MAX)
+            {
+                log << "Animation channel for unknown node "
+                    << inchannel->mNodeName.C_Str()
+                    << ", skipping..." << std::endl;
+                continue;
+            }
+
+            channels << "    {" << node << ", ";
+            write_vector_track(
+                inchannel->mNodeName,
+                inchannel->mPositionKeys, inchannel->mNumPositionKeys,
+                ticks_per_second
+            );
+            channels << ", ";
+
+            std::vector<double> key_times;
+            std::vector<aiQuaternion> rotations;
+            std::vector<unsigned short> packed;
+            for(unsigned k = 0; k < inchannel->mNumRotationKeys; ++k)
+            {
+                key_times.push_back(
+                    inchannel->mRotationKeys[k].mTime / ticks_per_second
+                );
+                rotations.push_back(inchannel->mRotationKeys[k].mValue);
+            }
+            std::vector<unsigned> kept = reduce_keys(
+                key_times, rotations,
+                reduction_tolerance(
+                    inchannel->mNodeName, rotation_quantization_error
+                ),
+                lerp_rotation, rotation_error
+            );
+            original_keys += rotations.size();
+            reduced_keys += kept.size();
+            for(unsigned k: kept) quantize_rotation(rotations[k], packed);
+            channels << kept.size() << ", " << write_times(key_times, kept)
+                     << ", " << write_keys(packed) << ", ";
+
+            write_vector_track(
+                inchannel->mNodeName,
+                inchannel->mScalingKeys, inchannel->mNumScalingKeys,
+                ticks_per_second
+            );
+            channels << "},\n";
+
+            channel_count++;
+        }
+
+        log << "Animation " << inanim->mName.C_Str() << ": "
+            << original_keys << " keys reduced to " << reduced_keys
+            << std::endl;
+
+        animations
+            << "    {" << escape_string(inanim->mName.C_Str()) << ", "
+            << (float)(inanim->mDuration / ticks_per_second) << ", ";
+        if(channel_count == start_channel) animations << "NULL, 0},\n";
+        else
+        {
+            animations
+                << options.name_prefix << "_channels + " << start_channel
+                << ", " << channel_count - start_channel << "},\n";
+        }
+        animation_count++;
     }
+
+    times << "\n};\n";
+    keys << "\n};\n";
+    channels << "};\n";
+    animations << "};\n";
+
+    if(time_count != 0) out << times.str() << "\n";
+    if(key_count != 0) out << keys.str() << "\n";
+    if(channel_count != 0) out << channels.str() << "\n";
+    if(animation_count != 0) out << animations.str() << "\n";
 }
 
-void construct_node_key(
-    unsigned& counter,
-    aiNode* node,
-    std::map<aiNode*, unsigned>& node_key
+void writer::write_cpp_traits(
+    bool position_present,
+    bool normal_present,
+    bool uv0_present,
+    bool skin_present
 ){
-    if(!node) return;
-    node_key[node] = counter++;
-    for(unsigned i = 0; i < node->mNumChildren; ++i)
+    const std::string& prefix = options.name_prefix;
+    std::string attributes;
+    if(position_present) attributes += " | POSITION";
+    if(normal_present) attributes += " | NORMAL";
+    if(uv0_present) attributes += " | UV0";
+    if(skin_present) attributes += " | SKIN";
+    attributes = attributes.empty() ? "0" : attributes.substr(3);
+
+    out
+        << "\n" << cpp17_condition
+        << "namespace\n{\nstruct " << prefix << "_model {};\n}\n\n"
+        << "namespace modelheader\n{\n"
+        << "template<>\n"
+        << "struct model_traits<" << prefix << "_model>\n{\n"
+        << "    using vertex_type = " << prefix << "_vertex;\n"
+        << "    using index_type = "
+        << (options.size_t_indices ? "size_t" : "unsigned") << ";\n";
+    if(skin_present)
+        out << "    using skin_vertex_type = " << prefix << "_skin_vertex;\n";
+    out
+        << "\n"
+        << "    static constexpr unsigned attributes = " << attributes << ";\n"
+        << "    static constexpr bool has_position = "
+        << (position_present ? "true" : "false") << ";\n"
+        << "    static constexpr bool has_normal = "
+        << (normal_present ? "true" : "false") << ";\n"
+        << "    static constexpr bool has_uv0 = "
+        << (uv0_present ? "true" : "false") << ";\n"
+        << "    static constexpr bool has_skin = "
+        << (skin_present ? "true" : "false") << ";\n"
+        << "    static constexpr bool has_info = "
+        << (options.disable_info ? "false" : "true") << ";\n"
+        << "    static constexpr unsigned primitive = " << prefix << "_primitive;\n"
+        << "\n"
+        << "    static constexpr std::size_t vertex_stride = "
+        << prefix << "_vertex_stride;\n"
+        << "    static constexpr std::size_t vertex_count = "
+        << prefix << "_vertex_count;\n"
+        << "    static constexpr std::size_t index_count = "
+        << prefix << "_index_count;\n"
+        << "    static constexpr int position_offset = "
+        << prefix << "_position_offset;\n"
+        << "    static constexpr int normal_offset = "
+        << prefix << "_normal_offset;\n"
+        << "    static constexpr int uv0_offset = "
+        << prefix << "_uv0_offset;\n";
+    if(!options.disable_info)
+    {
+        out
+            << "    static constexpr std::size_t material_count = "
+            << prefix << "_material_count;\n"
+            << "    static constexpr std::size_t mesh_count = "
+            << prefix << "_mesh_count;\n"
+            << "    static constexpr std::size_t node_count = "
+            << prefix << "_node_count;\n"
+            << "    static constexpr std::size_t node_bounds_stride = "
+            << prefix << "_node_bounds_stride;\n";
+    }
+    out
+        << "\n"
+        << "    static constexpr span<vertex_type> vertices()\n"
+        << "    {\n"
+        << "        return {" << prefix << "_vertex_data, vertex_count};\n"
+        << "    }\n"
+        << "\n"
+        << "    static constexpr span<index_type> indices()\n"
+        << "    {\n"
+        << "        return {" << prefix << "_indices, index_count};\n"
+        << "    }\n";
+    if(skin_present)
+    {
+        out
+            << "\n"
+            << "    static constexpr span<skin_vertex_type> skin()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_skin_data, vertex_count};\n"
+            << "    }\n";
+    }
+    if(!options.disable_info)
     {
-        construct_node_key(counter, node->mChildren[i], node_key);
+        out
+            << "\n"
+            << "    static constexpr span<modelheader_material> materials()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_materials, material_count};\n"
+            << "    }\n"
+            << "\n"
+            << "    static constexpr span<modelheader_mesh> meshes()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_meshes, mesh_count};\n"
+            << "    }\n"
+            << "\n"
+            << "    static constexpr span<modelheader_node> nodes()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_private_data.nodes, node_count};\n"
+            << "    }\n"
+            << "\n"
+            << "    static constexpr span<float> node_local_bounds()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_node_local_bounds, "
+            << "6 * node_bounds_stride};\n"
+            << "    }\n"
+            << "\n"
+            << "    static constexpr span<float> node_world_bounds()\n"
+            << "    {\n"
+            << "        return {" << prefix << "_node_world_bounds, "
+            << "6 * node_bounds_stride};\n"
+            << "    }\n";
     }
+    out
+        << "};\n"
+        << "}\n\n"
+        << "static_assert(\n"
+        << "    sizeof(" << prefix << "_vertex) == "
+        << prefix << "_vertex_stride * sizeof(float),\n"
+        << "    \"" << prefix << "_vertex must match the vertex layout\"\n"
+        << ");\n"
+        << "#endif\n";
 }
 
-void write_scene(const aiScene* scene)
+/* Assimp triangulates polygons, but keeps points and lines in meshes of their
+ * own, and hand-built scenes may mix anything.
+ */
+bool has_only_triangles(const aiMesh* mesh)
+{
+    for(unsigned i = 0; i < mesh->mNumFaces; ++i)
+        if(mesh->mFaces[i].mNumIndices != 3) return false;
+    return true;
+}
+
+bool writer::write_scene(const aiScene* scene)
 {
     std::stringstream vertices;
+    std::stringstream skin;
+    std::stringstream joints;
     std::stringstream indices;
     std::stringstream materials;
     std::stringstream meshes;
@@ -332,30 +1356,46 @@ void write_scene(const aiScene* scene)
     std::stringstream private_declaration;
     std::stringstream private_content;
 
-    unsigned vertex_count = 0;
+    size_t vertex_count = 0;
     unsigned vertex_stride = 0;
-    unsigned index_count = 0;
+    size_t index_count = 0;
+    size_t list_index_count = 0;
+    size_t last_index = 0;
     unsigned material_count = 0;
     unsigned mesh_count = 0;
     unsigned node_count = 0;
+    unsigned animation_count = 0;
     int position_offset = -1;
     int normal_offset = -1;
     int uv0_offset = -1;
     bool position_present = false;
     bool normal_present = false;
     bool uv0_present = false;
-    std::map<unsigned, unsigned> mesh_key;
-    std::map<aiNode*, unsigned> node_key;
+    bool skin_present = false;
+    std::vector<unsigned> mesh_key(scene->mNumMeshes, UINT_MAX);
+    std::unordered_map<std::string, unsigned> joint_key;
+    std::vector<std::pair<unsigned, aiMatrix4x4>> joint_sources;
+    std::vector<std::vector<unsigned>> mesh_joints(scene->mNumMeshes);
+    std::vector<aabb> mesh_bounds;
+    std::vector<aabb> node_local_bounds;
+    std::vector<aabb> node_world_bounds;
 
-    vertices
-        << "static MODELHEADER_CONST float "
-        << options.name_prefix << "_vertices[] = {\n    ";
+    /* Inverse bind matrices must cancel the bind pose exactly */
+    joints.precision(std::numeric_limits<float>::max_digits10);
+    joints
+        << "static MODELHEADER_CONST struct modelheader_joint "
+        << options.name_prefix << "_joints[] = {\n";
+    const char* index_type = options.size_t_indices ? "size_t" : "unsigned";
+    std::string restart_index = options.size_t_indices ?
+        "(size_t)-1" : std::to_string(strip_restart_index);
     indices
-        << "static MODELHEADER_CONST unsigned "
+        << "static MODELHEADER_CONST " << index_type << " "
         << options.name_prefix << "_indices[] = {\n    ";
     materials
         << "static MODELHEADER_CONST struct modelheader_material "
         << options.name_prefix << "_materials[] = {\n";
+    /* Mesh bounds must read back exactly to stay conservative */
+    meshes.precision(std::numeric_limits<float>::max_digits10);
     meshes
         << "static MODELHEADER_CONST struct modelheader_mesh "
         << options.name_prefix << "_meshes[] = {\n";
@@ -385,6 +1425,31 @@ void write_scene(const aiScene* scene)
         material_count++;
     }
 
+    node_table table(scene->mRootNode);
+    node_count = table.nodes.size();
+
+    /* Only meshes of triangles are written */
+    std::vector<bool> mesh_written(scene->mNumMeshes);
+    for(unsigned i = 0; i < scene->mNumMeshes; ++i)
+    {
+        aiMesh* inmesh = scene->mMeshes[i];
+        mesh_written[i] = inmesh->HasFaces() && has_only_triangles(inmesh);
+    }
+
+    /* Joints are keyed by their node and inverse bind matrix, since meshes
+     * sharing a bone may still have different mesh spaces.
+     */
+    auto add_joint = [&](unsigned node, const aiMatrix4x4& inverse_bind){
+        std::string key(
+            reinterpret_cast<const char*>(&inverse_bind),
+            sizeof(inverse_bind)
+        );
+        key += std::to_string(node);
+        auto it = joint_key.emplace(key, joint_sources.size());
+        if(it.second) joint_sources.emplace_back(node, inverse_bind);
+        return it.first->second;
+    };
+
     /* Vertex format pre-pass */
     for(unsigned i = 0; i < scene->mNumMeshes; ++i)
     {
@@ -392,6 +1457,56 @@ void write_scene(const aiScene* scene)
         position_present |= inmesh->HasPositions();
         normal_present |= inmesh->HasNormals();
         uv0_present |= inmesh->HasTextureCoords(0);
+
+        if(!options.animations || !mesh_written[i]) continue;
+        for(unsigned j = 0; j < inmesh->mNumBones; ++j)
+        {
+            aiBone* bone = inmesh->mBones[j];
+            unsigned node = table.find(bone->mName);
+            if(node == UINT_MAX)
+            {
+                log << "Bone " << bone->mName.C_Str()
+                    << " has no matching node." << std::endl;
+                return false;
+            }
+            mesh_joints[i].push_back(add_joint(node, bone->mOffsetMatrix));
+        }
+    }
+    skin_present = !joint_sources.empty();
+
+    /* Meshes without bones in a skinned model are bound rigidly to the node
+     * that places them, so that the whole model can be drawn with skinning.
+     */
+    if(skin_present)
+    {
+        std::vector<unsigned> mesh_node(scene->mNumMeshes, UINT_MAX);
+        for(unsigned i = table.nodes.size(); i-- > 0;)
+        {
+            aiNode* node = table.nodes[i];
+            for(unsigned j = 0; j < node->mNumMeshes; ++j)
+                mesh_node[node->mMeshes[j]] = i;
+        }
+
+        for(unsigned i = 0; i < scene->mNumMeshes; ++i)
+        {
+            aiMesh* inmesh = scene->mMeshes[i];
+            if(inmesh->HasBones() || !mesh_written[i]) continue;
+            if(mesh_node[i] == UINT_MAX)
+            {
+                log << "Mesh " << inmesh->mName.C_Str()
+                    << " has no bones and no node, it stays in place."
+                    << std::endl;
+                continue;
+            }
+            mesh_joints[i].push_back(add_joint(mesh_node[i], aiMatrix4x4()));
+        }
+    }
+
+    if(joint_sources.size() > 256)
+    {
+        log << "Too many joints (" << joint_sources.size()
+            << "), at most 256 are supported." << std::endl;
+        return false;
     }
     normal_present = normal_present && !options.delete_normal;
     uv0_present = uv0_present && !options.delete_uv;
@@ -414,36 +1529,193 @@ void write_scene(const aiScene* scene)
         vertex_stride += 2;
     }
 
+    /* Mesh order. Nodes refer to meshes through mesh_key, so they follow
+     * the meshes wherever they end up.
+     */
+    std::vector<unsigned> mesh_order(scene->mNumMeshes);
+    for(unsigned i = 0; i < scene->mNumMeshes; ++i) mesh_order[i] = i;
+    if(options.sort_meshes)
+    {
+        std::vector<aiVector3D> centroids(scene->mNumMeshes);
+        for(unsigned i = 0; i < scene->mNumMeshes; ++i)
+        {
+            aiMesh* inmesh = scene->mMeshes[i];
+            if(!inmesh->HasPositions() || inmesh->mNumVertices == 0)
+                continue;
+            aabb bounds;
+            for(unsigned j = 0; j < inmesh->mNumVertices; ++j)
+                bounds.add(inmesh->mVertices[j]);
+            centroids[i] = (bounds.min + bounds.max) * 0.5f;
+        }
+        mesh_order = spatial_order(centroids, options.hilbert);
+    }
+
     /* Actual vertex/index writing pass */
-    for(unsigned i = 0; i < scene->mNumMeshes; ++i)
+    for(unsigned i: mesh_order)
     {
-        unsigned start_index = index_count;
-        unsigned start_vertex = vertex_count;
-        unsigned size = 0;
+        size_t start_vertex = vertex_count;
 
         aiMesh* inmesh = scene->mMeshes[i];
         if(!inmesh->HasFaces())
         {
-            std::cerr << "Mesh " << inmesh->mName.C_Str()
-                      << " has no faces, skipping..." << std::endl;
+            log << "Mesh " << inmesh->mName.C_Str()
+                << " has no faces, skipping..." << std::endl;
+            continue;
+        }
+        if(!mesh_written[i])
+        {
+            log << "Mesh " << inmesh->mName.C_Str()
+                << " has faces that are not triangles, skipping..."
+                << std::endl;
             continue;
         }
         mesh_key[i] = mesh_count++;
 
-        /* Add indices */
+        /* The largest unsigned value is reserved for primitive restart */
+        if(
+            !options.size_t_indices &&
+            start_vertex + inmesh->mNumVertices > (size_t)UINT_MAX
+        ){
+            log << "The model has too many vertices for 32-bit indices, "
+                << "use --size-t-indices." << std::endl;
+            return false;
+        }
+
+        std::vector<unsigned> mesh_indices;
+        mesh_indices.reserve((size_t)inmesh->mNumFaces * 3);
         for(unsigned j = 0; j < inmesh->mNumFaces; ++j)
         {
             aiFace* face = inmesh->mFaces + j;
-            index_count+=3;
-            size+=3;
-            indices
-                << start_vertex + face->mIndices[0] << ","
-                << start_vertex + face->mIndices[1] << ","
-                << start_vertex + face->mIndices[2] << ",";
+            mesh_indices.insert(
+                mesh_indices.end(), face->mIndices, face->mIndices + 3
+            );
+        }
+
+        /* vertex_order[j] is the original index of output vertex j */
+        std::vector<unsigned> vertex_order(inmesh->mNumVertices);
+        for(unsigned j = 0; j < inmesh->mNumVertices; ++j) vertex_order[j] = j;
+
+        if(
+            options.sort_triangles != 0 &&
+            inmesh->mNumFaces >= options.sort_triangles &&
+            inmesh->HasPositions()
+        ){
+            std::vector<aiVector3D> centroids(inmesh->mNumFaces);
+            for(unsigned j = 0; j < inmesh->mNumFaces; ++j)
+            {
+                aiVector3D sum(0);
+                const unsigned* t = mesh_indices.data() + (size_t)j * 3;
+                for(unsigned k = 0; k < 3; ++k)
+                    sum += inmesh->mVertices[t[k]];
+                centroids[j] = sum * (1.0f / 3.0f);
+            }
+
+            std::vector<unsigned> sorted_indices;
+            sorted_indices.reserve(mesh_indices.size());
+            for(unsigned j: spatial_order(centroids, options.hilbert))
+            {
+                const unsigned* t = mesh_indices.data() + (size_t)j * 3;
+                sorted_indices.insert(sorted_indices.end(), t, t + 3);
+            }
+
+            /* Renumber vertices by first use, so that the vertex data is in
+             * the same order as the triangles. Unused vertices go last.
+             */
+            std::vector<unsigned> vertex_remap(inmesh->mNumVertices, UINT_MAX);
+            unsigned next_vertex = 0;
+            for(unsigned& index: sorted_indices)
+            {
+                if(vertex_remap[index] == UINT_MAX)
+                {
+                    vertex_order[next_vertex] = index;
+                    vertex_remap[index] = next_vertex++;
+                }
+                index = vertex_remap[index];
+            }
+            for(unsigned j = 0; j < inmesh->mNumVertices; ++j)
+            {
+                if(vertex_remap[j] == UINT_MAX)
+                    vertex_order[next_vertex++] = j;
+            }
+            mesh_indices.swap(sorted_indices);
+        }
+
+        if(options.strip)
+        {
+            size_t list_size = mesh_indices.size();
+            mesh_indices = stripify(mesh_indices, options.strip_restart);
+
+            log << "Mesh " << inmesh->mName.C_Str() << ": "
+                << list_size << " list indices, "
+                << mesh_indices.size() << " strip indices ("
+                << 100.0 - 100.0 * mesh_indices.size() / list_size
+                << "% reduction)" << std::endl;
+            list_index_count += list_size;
+
+            /* Join with the previous mesh so that the whole index buffer can
+             * also be drawn as one strip.
+             */
+            if(index_count != 0)
+            {
+                if(options.strip_restart)
+                {
+                    indices << restart_index << ",";
+                    index_count++;
+                }
+                else
+                {
+                    size_t first = start_vertex + mesh_indices[0];
+                    indices << last_index << "," << first << ",";
+                    index_count += 2;
+                    if(index_count % 2 == 1)
+                    {
+                        indices << first << ",";
+                        index_count++;
+                    }
+                }
+            }
+        }
+
+        /* Add indices */
+        size_t start_index = index_count;
+        size_t size = mesh_indices.size();
+        for(unsigned index: mesh_indices)
+        {
+            if(index == strip_restart_index && options.strip_restart)
+            {
+                indices << restart_index << ",";
+                continue;
+            }
+            last_index = start_vertex + index;
+            indices << last_index << ",";
+        }
+        index_count += size;
+
+        /* Gather the four most important bone influences of each vertex */
+        std::vector<std::vector<std::pair<float, unsigned>>> influences;
+        if(skin_present)
+        {
+            influences.resize(inmesh->mNumVertices);
+            for(unsigned j = 0; j < inmesh->mNumBones; ++j)
+            {
+                aiBone* bone = inmesh->mBones[j];
+                unsigned joint = mesh_joints[i][j];
+                for(unsigned k = 0; k < bone->mNumWeights; ++k)
+                {
+                    const aiVertexWeight& w = bone->mWeights[k];
+                    influences[w.mVertexId].emplace_back(w.mWeight, joint);
+                }
+            }
+            if(!inmesh->HasBones() && !mesh_joints[i].empty())
+            {
+                for(auto& in: influences)
+                    in.emplace_back(1.0f, mesh_joints[i][0]);
+            }
         }
 
         /* Add vertices */
-        for(unsigned j = 0; j < inmesh->mNumVertices; ++j)
+        aabb bounds;
+        for(unsigned j: vertex_order)
         {
             vertex_count++;
             if(position_present)
@@ -452,6 +1724,7 @@ void write_scene(const aiScene* scene)
                 if(inmesh->HasPositions())
                     p = inmesh->mVertices[j];
                 vertices << p.x << "," << p.y << "," << p.z << ",";
+                bounds.add(p);
             }
 
             if(normal_present)
@@ -469,35 +1742,109 @@ void write_scene(const aiScene* scene)
                     uv = inmesh->mTextureCoords[0][j];
                 vertices << uv.x << "," << uv.y << ",";
             }
+
+            if(skin_present)
+            {
+                /* Joint indices as 4xuint8, followed by weights as 4xunorm8
+                 * that always sum up to 255.
+                 */
+                std::vector<std::pair<float, unsigned>>& in = influences[j];
+                std::sort(in.rbegin(), in.rend());
+                if(in.size() > 4) in.resize(4);
+
+                unsigned joint[4] = {0, 0, 0, 0};
+                unsigned weight[4] = {0, 0, 0, 0};
+                float total = 0;
+                for(auto& p: in) total += p.first;
+                if(total > 0)
+                {
+                    unsigned sum = 0;
+                    for(unsigned k = 0; k < in.size(); ++k)
+                    {
+                        joint[k] = in[k].second;
+                        weight[k] = lround(in[k].first / total * 255.0f);
+                        sum += weight[k];
+                    }
+                    weight[0] += 255 - sum;
+                }
+                for(unsigned k = 0; k < 4; ++k) skin << joint[k] << ",";
+                for(unsigned k = 0; k < 4; ++k) skin << weight[k] << ",";
+            }
         }
 
+        /* Bounding sphere around the box center */
+        aiVector3D center(0);
+        float radius = 0;
+        if(bounds.empty()) bounds.min = bounds.max = center;
+        else
+        {
+            center = (bounds.min + bounds.max) * 0.5f;
+            double radius_squared = 0;
+            for(unsigned j = 0; j < inmesh->mNumVertices; ++j)
+            {
+                double sum = 0;
+                for(unsigned k = 0; k < 3; ++k)
+                {
+                    double d = (double)inmesh->mVertices[j][k] - center[k];
+                    sum += d * d;
+                }
+                radius_squared = std::max(radius_squared, sum);
+            }
+            radius = round_up(sqrt(radius_squared));
+        }
+        mesh_bounds.push_back(bounds);
+
         /* Add this mesh */
         meshes
             << "    {" << escape_string(inmesh->mName.C_Str()) << ", &"
             << options.name_prefix << "_materials["
             << inmesh->mMaterialIndex << "], "
-            << start_index << ", " << size << "},\n";
+            << start_index << ", " << size << ", "
+            << (options.strip ? "MODELHEADER_TRIANGLE_STRIP" : "MODELHEADER_TRIANGLES")
+            << ", {" << bounds.min.x << ", " << bounds.min.y << ", "
+            << bounds.min.z << "}, {" << bounds.max.x << ", " << bounds.max.y
+            << ", " << bounds.max.z << "}, {" << center.x << ", " << center.y
+            << ", " << center.z << ", " << radius << "}},\n";
     }
 
-    construct_node_key(
-        node_count,
-        scene->mRootNode,
-        node_key
-    );
+    if(options.strip && list_index_count != 0)
+    {
+        log << "Total: " << list_index_count << " list indices, "
+            << index_count << " strip indices ("
+            << 100.0 - 100.0 * index_count / list_index_count
+            << "% reduction)" << std::endl;
+    }
 
-    node_count = 0;
+    compute_node_bounds(
+        table,
+        mesh_key,
+        mesh_bounds,
+        node_local_bounds,
+        node_world_bounds
+    );
+    unsigned node_bounds_stride = (node_count + 7) / 8 * 8;
 
-    write_node(
-        node_count,
+    write_nodes(
+        table,
         mesh_key,
-        node_key,
-        scene->mRootNode,
         nodes,
         private_declaration,
         private_content
     );
 
-    vertices << "\n};\n";
+    for(const auto& source: joint_sources)
+    {
+        joints
+            << "    {&" << options.name_prefix << "_private_data.nodes["
+            << source.first << "], {";
+        for(unsigned i = 0; i < 4*4; ++i)
+        {
+            joints << source.second[i/4][i%4] << ",";
+        }
+        joints << "}},\n";
+    }
+
+    joints << "};\n";
     indices << "\n};\n";
     materials << "};\n";
     meshes << "};\n";
@@ -506,21 +1853,68 @@ void write_scene(const aiScene* scene)
         << "    const struct modelheader_node nodes[" << node_count << "];\n";
     private_content << nodes.str() <<  "};\n";
 
-    std::cout << vertices.str() << "\n" << indices.str() << "\n";
+    /* Everything that can fail has been checked by now, so a failed
+     * conversion leaves the output stream untouched.
+     */
+    write_preamble();
+
+    if(options.cpp)
+    {
+        out
+            << cpp17_condition
+            << "struct " << options.name_prefix << "_vertex\n{\n";
+        if(position_present) out << "    float position[3];\n";
+        if(normal_present) out << "    float normal[3];\n";
+        if(uv0_present) out << "    float uv0[2];\n";
+        out << "};\n";
+        if(skin_present)
+        {
+            out
+                << "\nstruct " << options.name_prefix << "_skin_vertex\n{\n"
+                << "    unsigned char joints[4];\n"
+                << "    unsigned char weights[4];\n"
+                << "};\n";
+        }
+        out << "#endif\n\n";
+    }
+
+    write_typed_array(
+        "float", "vertices", "vertex", "vertex_data", vertices.str()
+    );
+    if(skin_present)
+    {
+        write_typed_array(
+            "unsigned char", "skin", "skin_vertex", "skin_data", skin.str()
+        );
+    }
+    out << indices.str() << "\n";
 
     if(!options.disable_info)
     {
-        std::cout
+        out
             << materials.str() << "\n"
             << meshes.str() << "\n"
             << private_declaration.str()
             << private_content.str() << "\n"
-            << "static MODELHEADER_CONST modelheader_node* "
+            << "static MODELHEADER_CONST struct modelheader_node* "
             << options.name_prefix << "_nodes = "
             << options.name_prefix << "_private_data.nodes;\n\n";
+        write_bounds_soa(
+            "node_local_bounds", node_local_bounds, node_bounds_stride
+        );
+        write_bounds_soa(
+            "node_world_bounds", node_world_bounds, node_bounds_stride
+        );
+        out << "\n";
     }
 
-    std::cout
+    if(options.animations)
+    {
+        if(skin_present) out << joints.str() << "\n";
+        write_animations(scene, table, animation_count);
+    }
+
+    out
         << "#define " << options.name_prefix
         << "_vertex_stride " << vertex_stride << "\n"
         << "#define " << options.name_prefix
@@ -528,90 +1922,187 @@ void write_scene(const aiScene* scene)
         << "#define " << options.name_prefix
         << "_index_count " << index_count << "\n"
         << "#define " << options.name_prefix
+        << "_index_size sizeof(" << index_type << ")\n"
+        << "#define " << options.name_prefix
         << "_position_offset " << position_offset << "\n"
         << "#define " << options.name_prefix
         << "_normal_offset " << normal_offset << "\n"
         << "#define " << options.name_prefix
-        << "_uv0_offset " << uv0_offset << "\n";
+        << "_uv0_offset " << uv0_offset << "\n"
+        << "#define " << options.name_prefix << "_primitive "
+        << (options.strip ? "MODELHEADER_TRIANGLE_STRIP" : "MODELHEADER_TRIANGLES")
+        << "\n";
+    if(options.strip && options.strip_restart)
+    {
+        out
+            << "#define " << options.name_prefix
+            << "_primitive_restart_index "
+            << (options.size_t_indices ? "((size_t)-1)" : restart_index + "u")
+            << "\n";
+    }
     if(!options.disable_info)
     {
-        std::cout
+        out
             << "#define " << options.name_prefix
             << "_material_count " << material_count << "\n"
             << "#define " << options.name_prefix
             << "_mesh_count " << mesh_count << "\n"
             << "#define " << options.name_prefix
-            << "_node_count " << node_count << "\n";
+            << "_node_count " << node_count << "\n"
+            << "#define " << options.name_prefix
+            << "_node_bounds_stride " << node_bounds_stride << "\n";
+    }
+    if(options.animations)
+    {
+        out
+            << "#define " << options.name_prefix
+            << "_joint_count " << joint_sources.size() << "\n"
+            << "#define " << options.name_prefix
+            << "_animation_count " << animation_count << "\n";
+    }
+    if(skin_present)
+    {
+        out
+            << "#define " << options.name_prefix << "_skin_stride 8\n"
+            << "#define " << options.name_prefix << "_joints_offset 0\n"
+            << "#define " << options.name_prefix << "_weights_offset 4\n";
     }
-}
 
-int main(int argc, char** argv)
-{
-    (void)argc;
-    if(!parse_args(argv)) return 1;
-    if(options.name_prefix == "")
-    {
-        size_t start = options.input_file.find_last_of("/\\");
-        if(start == std::string::npos) start = 0;
-        else start++;
-        options.name_prefix = options.input_file.substr(
-            start, options.input_file.find('.', start)
-        );
-        std::transform(
-            options.name_prefix.begin(),
-            options.name_prefix.end(),
-            options.name_prefix.begin(),
-            [](char c){
-                c = tolower(c);
-                if(isspace(c) || ispunct(c)) c = '_';
-                return c;
-            }
-        );
-        options.name_prefix.erase(
-            std::remove_if(
-                options.name_prefix.begin(),
-                options.name_prefix.end(),
-                [](char c){ return !isalnum(c) && c != '_'; }
-            ),
-            options.name_prefix.end()
+    if(options.cpp)
+    {
+        write_cpp_traits(
+            position_present, normal_present, uv0_present, skin_present
         );
     }
+    return true;
+}
+
+}
 
-    options.uppercase_name_prefix = options.name_prefix;
+namespace modelheader
+{
+
+std::string default_name_prefix(const std::string& path)
+{
+    size_t start = path.find_last_of("/\\");
+    if(start == std::string::npos) start = 0;
+    else start++;
+    std::string name_prefix = path.substr(start, path.find('.', start));
     std::transform(
-        options.name_prefix.begin(),
-        options.name_prefix.end(),
-        options.uppercase_name_prefix.begin(),
-        toupper
+        name_prefix.begin(),
+        name_prefix.end(),
+        name_prefix.begin(),
+        [](char c){
+            c = tolower(c);
+            if(isspace(c) || ispunct(c)) c = '_';
+            return c;
+        }
     );
+    name_prefix.erase(
+        std::remove_if(
+            name_prefix.begin(),
+            name_prefix.end(),
+            [](char c){ return !isalnum(c) && c != '_'; }
+        ),
+        name_prefix.end()
+    );
+    if(name_prefix.empty() || isdigit(name_prefix[0]))
+        name_prefix = "model" + name_prefix;
+    return name_prefix;
+}
 
-    Assimp::Importer importer;
-    importer.SetPropertyInteger(
-        AI_CONFIG_PP_RVC_FLAGS,
+namespace
+{
+
+/* Sets up an importer for the given options and returns the post-processing
+ * flags to use with it.
+ */
+unsigned configure_importer(const options& opts, Assimp::Importer& importer)
+{
+    int removed_components =
         aiComponent_COLORS |
-        aiComponent_BONEWEIGHTS |
-        aiComponent_ANIMATIONS |
         aiComponent_LIGHTS |
-        aiComponent_CAMERAS
-    );
+        aiComponent_CAMERAS;
+    if(opts.animations)
+        importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 4);
+    else
+        removed_components |= aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS;
+    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removed_components);
 
-    auto flags =
+    unsigned flags =
         aiProcessPreset_TargetRealtime_MaxQuality |
         aiProcess_FlipUVs |
         aiProcess_RemoveComponent;
-    if(options.pretransform) flags |= aiProcess_PreTransformVertices;
+    /* Animations need the node hierarchy to stay intact. */
+    if(opts.pretransform && !opts.animations)
+        flags |= aiProcess_PreTransformVertices;
+    return flags;
+}
+
+}
 
-    const aiScene* scene = importer.ReadFile(options.input_file, flags);
+bool convert(
+    const options& opts,
+    const std::string& path,
+    std::ostream& out,
+    std::ostream& log
+){
+    Assimp::Importer importer;
+    unsigned flags = configure_importer(opts, importer);
+    const aiScene* scene = importer.ReadFile(path, flags);
 
     if(!scene)
     {
-        std::cerr << "Failed to open file " << options.input_file << std::endl;
-        return 1;
+        log << "Failed to open file " << path << ": "
+            << importer.GetErrorString() << std::endl;
+        return false;
     }
 
-    write_preamble();
-    write_scene(scene);
-    write_prologue();
+    options file_opts = opts;
+    if(file_opts.source_name.empty()) file_opts.source_name = path;
+    return convert(file_opts, scene, out, log);
+}
+
+bool convert(
+    const options& opts,
+    const void* data,
+    size_t size,
+    const char* format_hint,
+    std::ostream& out,
+    std::ostream& log
+){
+    Assimp::Importer importer;
+    unsigned flags = configure_importer(opts, importer);
+    const aiScene* scene = importer.ReadFileFromMemory(
+        data, size, flags, format_hint ? format_hint : ""
+    );
+
+    if(!scene)
+    {
+        log << "Failed to read model from memory: "
+            << importer.GetErrorString() << std::endl;
+        return false;
+    }
+    return convert(opts, scene, out, log);
+}
+
+bool convert(
+    const options& opts,
+    const aiScene* scene,
+    std::ostream& out,
+    std::ostream& log
+){
+    if(opts.animations && opts.disable_info)
+    {
+        log << "Animations need node information, they cannot be exported "
+            "without it." << std::endl;
+        return false;
+    }
+
+    writer w(opts, out, log);
+    if(!w.write_scene(scene)) return false;
+    w.write_prologue();
+    return true;
+}
 
-    return 0;
 }
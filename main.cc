@@ -0,0 +1,228 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include "modelheader_generator.hh"
+
+void print_help(const char* name)
+{
+    std::cerr
+        << "Usage: " << name
+        << " [-p] [-dnt] [-m] [-s] [-a] [-n name_prefix] model_file"
+        << std::endl
+        << "-p disables pre-transformed primitives." << std::endl
+        << "-m disables material, mesh and node information." << std::endl
+        << "-d deletes parts of vertex data. 'n' removes normals, "
+        << "'t' removes UV coordinates." << std::endl
+        << "-n sets the default name prefix for the model." << std::endl
+        << "-s writes triangle strips joined by primitive restart indices."
+        << std::endl
+        << "--strip-degenerate writes triangle strips joined by degenerate "
+        << "triangles." << std::endl
+        << "-a exports bones, vertex weights and animations. Implies -p."
+        << std::endl
+        << "--anim-tolerance sets the maximum error of keyframe reduction and "
+        << "quantization, in model units for translation and scaling and in "
+        << "radians for rotation. Defaults to 0.001." << std::endl
+        << "--cpp adds a typed C++17 API for the model." << std::endl
+        << "--size-t-indices writes indices as size_t, for models with more "
+        << "than 2^32 - 1 vertices." << std::endl
+        << "--sort-meshes orders meshes along a space-filling curve through "
+        << "their centers." << std::endl
+        << "--sort-triangles n orders the triangles and vertices of meshes "
+        << "with at least n triangles along a space-filling curve." << std::endl
+        << "--hilbert uses a Hilbert curve for sorting instead of a Morton "
+        << "curve." << std::endl;
+}
+
+bool parse_args(
+    char** argv,
+    modelheader::options& options,
+    std::string& input_file
+){
+    const char* name = *argv++;
+    bool skip_flags = false;
+    unsigned parameter_count = 0;
+    while(*argv)
+    {
+        const char* arg = *argv;
+        if(!skip_flags && arg[0] == '-')
+        {
+            if(arg[1] == '-')
+            {
+                if(arg[2] == 0) skip_flags = true;
+                else if(!strcmp(arg+2, "help")) goto fail;
+                else if(!strcmp(arg+2, "no-pretransform"))
+                {
+                    options.pretransform = false;
+                }
+                else if(!strcmp(arg+2, "strip"))
+                {
+                    options.strip = true;
+                }
+                else if(!strcmp(arg+2, "strip-degenerate"))
+                {
+                    options.strip = true;
+                    options.strip_restart = false;
+                }
+                else if(!strcmp(arg+2, "cpp"))
+                {
+                    options.cpp = true;
+                }
+                else if(!strcmp(arg+2, "size-t-indices"))
+                {
+                    options.size_t_indices = true;
+                }
+                else if(!strcmp(arg+2, "sort-meshes"))
+                {
+                    options.sort_meshes = true;
+                }
+                else if(!strcmp(arg+2, "sort-triangles"))
+                {
+                    argv++;
+                    char* end = nullptr;
+                    if(*argv) options.sort_triangles = strtoul(*argv, &end, 10);
+                    if(!*argv || *end != 0 || options.sort_triangles == 0)
+                    {
+                        std::cerr << "Missing or invalid triangle count"
+                            << std::endl;
+                        goto fail;
+                    }
+                }
+                else if(!strcmp(arg+2, "hilbert"))
+                {
+                    options.hilbert = true;
+                }
+                else if(!strcmp(arg+2, "animations"))
+                {
+                    options.animations = true;
+                }
+                else if(!strcmp(arg+2, "anim-tolerance"))
+                {
+                    argv++;
+                    char* end = nullptr;
+                    if(*argv) options.anim_tolerance = strtod(*argv, &end);
+                    if(!*argv || *end != 0 || options.anim_tolerance < 0)
+                    {
+                        std::cerr << "Missing or invalid animation tolerance"
+                            << std::endl;
+                        goto fail;
+                    }
+                }
+                else
+                {
+                    std::cerr << "Unknown long flag " << arg+2 << std::endl;
+                    goto fail;
+                }
+            }
+            else if(arg[1] == 'p' && arg[2] == 0)
+            {
+                options.pretransform = false;
+            }
+            else if(arg[1] == 'm' && arg[2] == 0)
+            {
+                options.disable_info = true;
+            }
+            else if(arg[1] == 's' && arg[2] == 0)
+            {
+                options.strip = true;
+            }
+            else if(arg[1] == 'a' && arg[2] == 0)
+            {
+                options.animations = true;
+            }
+            else if(arg[1] == 'n' && arg[2] == 0)
+            {
+                argv++;
+                if(!*argv)
+                {
+                    std::cerr << "Missing name prefix" << std::endl;
+                    goto fail;
+                }
+                options.name_prefix = *argv;
+            }
+            else if(arg[1] == 'd')
+            {
+                for(unsigned i = 2; arg[i] != 0; ++i)
+                {
+                    switch(arg[i]) 
+                    {
+                    case 'n':
+                        options.delete_normal = true;
+                        break;
+                    case 't':
+                        options.delete_uv = true;
+                        break;
+                    default:
+                        std::cerr << "Unknown vertex attribute \""
+                            << arg[i] << "\"" << std::endl;
+                        goto fail;
+                    }
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown flag " << arg+1 << std::endl;
+                goto fail;
+            }
+        }
+        else
+        {
+            if(parameter_count == 0)
+            {
+                input_file = arg;
+                parameter_count++;
+            }
+            else
+            {
+                std::cerr << "Too many parameters." << std::endl;
+                goto fail;
+            }
+        }
+        argv++;
+    }
+    if(parameter_count == 0) goto fail;
+    if(options.animations && options.disable_info)
+    {
+        std::cerr << "Animations need node information, -a and -m cannot be "
+            "combined." << std::endl;
+        goto fail;
+    }
+    return true;
+fail:
+    print_help(name);
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    modelheader::options options;
+    std::string input_file;
+    if(!parse_args(argv, options, input_file)) return 1;
+
+    return modelheader::convert(options, input_file, std::cout) ? 0 : 1;
+}
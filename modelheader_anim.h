@@ -0,0 +1,260 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MODELHEADER_ANIM_H
+#define MODELHEADER_ANIM_H
+
+#ifndef MODELHEADER_ANIMATION_TYPES_DECLARED
+#error "Include a model header generated with -a before modelheader_anim.h"
+#endif
+
+#include <math.h>
+
+/* Finds the key preceding time and the interpolation factor towards the next
+ * key. Times outside of the track are clamped to its ends.
+ */
+static inline unsigned modelheader_find_key(
+    const float* times,
+    unsigned count,
+    float time,
+    float* t
+){
+    unsigned lo = 0, hi = count - 1;
+    *t = 0.0f;
+    if(count == 1 || time <= times[0]) return 0;
+    if(time >= times[hi]) return hi;
+
+    while(hi - lo > 1)
+    {
+        unsigned mid = (lo + hi) / 2;
+        if(times[mid] <= time) lo = mid;
+        else hi = mid;
+    }
+    *t = (time - times[lo]) / (times[hi] - times[lo]);
+    return lo;
+}
+
+static inline void modelheader_sample_vector(
+    const float* times,
+    const unsigned short* keys,
+    unsigned count,
+    const float* bias,
+    const float* scale,
+    float time,
+    float* out
+){
+    float t;
+    unsigned k = modelheader_find_key(times, count, time, &t);
+    const unsigned short* a = keys + 3 * k;
+    const unsigned short* b = t > 0.0f ? a + 3 : a;
+    int i;
+    for(i = 0; i < 3; ++i)
+        out[i] = bias[i] + scale[i] * (a[i] + (b[i] - (float)a[i]) * t);
+}
+
+/* Decodes a rotation stored with the smallest three encoding into x, y, z, w.
+ */
+static inline void modelheader_decode_rotation(
+    const unsigned short* key,
+    float* q
+){
+    unsigned largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+    float sum = 0.0f;
+    unsigned i, j = 0;
+    for(i = 0; i < 4; ++i)
+    {
+        if(i == largest) continue;
+        q[i] = ((key[j++] & 0x7FFF) / 32767.0f * 2.0f - 1.0f) * 0.70710678f;
+        sum += q[i] * q[i];
+    }
+    q[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+}
+
+static inline void modelheader_sample_rotation(
+    const float* times,
+    const unsigned short* keys,
+    unsigned count,
+    float time,
+    float* q
+){
+    float t, a[4], b[4], dot = 0.0f, len = 0.0f;
+    unsigned k = modelheader_find_key(times, count, time, &t);
+    int i;
+    modelheader_decode_rotation(keys + 3 * k, a);
+    if(t <= 0.0f)
+    {
+        for(i = 0; i < 4; ++i) q[i] = a[i];
+        return;
+    }
+    modelheader_decode_rotation(keys + 3 * (k + 1), b);
+
+    /* Normalized lerp along the shorter arc */
+    for(i = 0; i < 4; ++i) dot += a[i] * b[i];
+    if(dot < 0.0f) t = -t;
+    for(i = 0; i < 4; ++i)
+    {
+        q[i] = a[i] * (1.0f - fabsf(t)) + b[i] * t;
+        len += q[i] * q[i];
+    }
+    len = 1.0f / sqrtf(len);
+    for(i = 0; i < 4; ++i) q[i] *= len;
+}
+
+/* Writes the local transforms of all nodes at the given time to local_pose,
+ * which must have room for 16 floats per node. Nodes without a channel keep
+ * their own transform. Matrices are row-major, like modelheader_node.
+ */
+static inline void modelheader_sample_pose_impl(
+    const struct modelheader_animation* animation,
+    float time,
+    const struct modelheader_node* nodes,
+    unsigned node_count,
+    float* local_pose
+){
+    unsigned i, j;
+    for(i = 0; i < node_count; ++i)
+        for(j = 0; j < 16; ++j)
+            local_pose[i*16+j] = nodes[i].transform[j];
+
+    for(i = 0; i < animation->channel_count; ++i)
+    {
+        const struct modelheader_channel* c = animation->channels + i;
+        float* m = local_pose + 16 * c->node;
+        float p[3] = {m[3], m[7], m[11]};
+        float s[3] = {1.0f, 1.0f, 1.0f};
+        float q[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+        if(c->position_count)
+            modelheader_sample_vector(
+                c->position_times, c->positions, c->position_count,
+                c->position_bias, c->position_scale, time, p
+            );
+        if(c->rotation_count)
+            modelheader_sample_rotation(
+                c->rotation_times, c->rotations, c->rotation_count, time, q
+            );
+        if(c->scaling_count)
+            modelheader_sample_vector(
+                c->scaling_times, c->scalings, c->scaling_count,
+                c->scaling_bias, c->scaling_scale, time, s
+            );
+
+        m[0] = (1.0f - 2.0f * (q[1]*q[1] + q[2]*q[2])) * s[0];
+        m[1] = 2.0f * (q[0]*q[1] - q[2]*q[3]) * s[1];
+        m[2] = 2.0f * (q[0]*q[2] + q[1]*q[3]) * s[2];
+        m[3] = p[0];
+        m[4] = 2.0f * (q[0]*q[1] + q[2]*q[3]) * s[0];
+        m[5] = (1.0f - 2.0f * (q[0]*q[0] + q[2]*q[2])) * s[1];
+        m[6] = 2.0f * (q[1]*q[2] - q[0]*q[3]) * s[2];
+        m[7] = p[1];
+        m[8] = 2.0f * (q[0]*q[2] - q[1]*q[3]) * s[0];
+        m[9] = 2.0f * (q[1]*q[2] + q[0]*q[3]) * s[1];
+        m[10] = (1.0f - 2.0f * (q[0]*q[0] + q[1]*q[1])) * s[2];
+        m[11] = p[2];
+        m[12] = m[13] = m[14] = 0.0f;
+        m[15] = 1.0f;
+    }
+}
+
+#define modelheader_sample_pose(model, animation, time, local_pose) \
+    modelheader_sample_pose_impl( \
+        &model ## _animations[animation], \
+        time, \
+        model ## _nodes, \
+        model ## _node_count, \
+        local_pose \
+    )
+
+static inline void modelheader_mat4_mul(
+    const float* a,
+    const float* b,
+    float* out
+){
+    int i, j;
+    for(i = 0; i < 4; ++i)
+        for(j = 0; j < 4; ++j)
+            out[i*4+j] =
+                a[i*4+0] * b[0*4+j] + a[i*4+1] * b[1*4+j] +
+                a[i*4+2] * b[2*4+j] + a[i*4+3] * b[3*4+j];
+}
+
+/* Accumulates local transforms into world transforms. Parents always precede
+ * their children in the node table, so one pass is enough.
+ */
+static inline void modelheader_world_pose_impl(
+    const struct modelheader_node* nodes,
+    unsigned node_count,
+    const float* local_pose,
+    float* world_pose
+){
+    unsigned i, j;
+    for(i = 0; i < node_count; ++i)
+    {
+        if(nodes[i].parent)
+            modelheader_mat4_mul(
+                world_pose + 16 * (nodes[i].parent - nodes),
+                local_pose + 16 * i,
+                world_pose + 16 * i
+            );
+        else for(j = 0; j < 16; ++j)
+            world_pose[i*16+j] = local_pose[i*16+j];
+    }
+}
+
+#define modelheader_world_pose(model, local_pose, world_pose) \
+    modelheader_world_pose_impl( \
+        model ## _nodes, \
+        model ## _node_count, \
+        local_pose, \
+        world_pose \
+    )
+
+/* Writes one skinning matrix per joint, to be indexed with the joint indices
+ * of the skin vertex data.
+ */
+static inline void modelheader_joint_matrices_impl(
+    const struct modelheader_joint* joints,
+    unsigned joint_count,
+    const struct modelheader_node* nodes,
+    const float* world_pose,
+    float* joint_matrices
+){
+    unsigned i;
+    for(i = 0; i < joint_count; ++i)
+        modelheader_mat4_mul(
+            world_pose + 16 * (joints[i].node - nodes),
+            joints[i].inverse_bind,
+            joint_matrices + 16 * i
+        );
+}
+
+#define modelheader_joint_matrices(model, world_pose, joint_matrices) \
+    modelheader_joint_matrices_impl( \
+        model ## _joints, \
+        model ## _joint_count, \
+        model ## _nodes, \
+        world_pose, \
+        joint_matrices \
+    )
+
+#endif
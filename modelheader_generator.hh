@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef MODELHEADER_GENERATOR_HH
+#define MODELHEADER_GENERATOR_HH
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+struct aiScene;
+
+namespace modelheader
+{
+
+struct options
+{
+    /* Used in the generated header and to derive the name prefix when none is
+     * given. Set to the file path when converting a file.
+     */
+    std::string source_name;
+    std::string name_prefix;
+    bool pretransform = true;
+    bool delete_normal = false;
+    bool delete_uv = false;
+    bool disable_info = false;
+    bool strip = false;
+    bool strip_restart = true;
+    bool animations = false;
+    double anim_tolerance = 0.001;
+    bool cpp = false;
+    bool size_t_indices = false;
+    bool sort_meshes = false;
+    unsigned sort_triangles = 0;
+    bool hilbert = false;
+};
+
+/* Derives a valid C identifier from a file name. */
+std::string default_name_prefix(const std::string& path);
+
+/* Each of these writes a model header to out and diagnostics to log. They
+ * return false on failure. No state is shared between calls, so they may be
+ * run concurrently from multiple threads.
+ */
+bool convert(
+    const options& opts,
+    const std::string& path,
+    std::ostream& out,
+    std::ostream& log = std::cerr
+);
+
+/* format_hint is the file extension of the data, like "obj". */
+bool convert(
+    const options& opts,
+    const void* data,
+    size_t size,
+    const char* format_hint,
+    std::ostream& out,
+    std::ostream& log = std::cerr
+);
+
+/* The scene is used as-is. Options that affect importing, such as
+ * pretransform, have no effect here. Import it with at least
+ * aiProcess_Triangulate, as meshes with faces that are not triangles are
+ * skipped, and aiProcess_FlipUVs to get the same texture coordinates as the
+ * other overloads. aiProcess_SortByPType moves points and lines out of
+ * meshes that also have triangles, so that those triangles are kept.
+ */
+bool convert(
+    const options& opts,
+    const aiScene* scene,
+    std::ostream& out,
+    std::ostream& log = std::cerr
+);
+
+}
+
+#endif
@@ -29,13 +29,31 @@ SOFTWARE.
 #define MODELHEADER_POS 1
 #define MODELHEADER_NORMAL 2
 #define MODELHEADER_UV0 3
+#define MODELHEADER_TRIANGLES 0
+#define MODELHEADER_TRIANGLE_STRIP 1
+
+static inline GLenum modelheader_gl_primitive_impl(unsigned primitive)
+{
+    return primitive == MODELHEADER_TRIANGLE_STRIP ?
+        GL_TRIANGLE_STRIP : GL_TRIANGLES;
+}
+
+#define modelheader_gl_primitive(model) \
+    modelheader_gl_primitive_impl(model ## _primitive)
+
+/* OpenGL has no 64-bit index type, so headers generated with
+ * --size-t-indices fail to compile here, as a negative array size, unless
+ * size_t happens to be 32 bits wide.
+ */
+#define modelheader_gl_check_index_size(model) \
+    ((void)sizeof(char[model ## _index_size == sizeof(unsigned) ? 1 : -1]))
 
 static inline void modelheader_gl_load_impl(
     const float* vertices,
     unsigned vertex_stride,
-    unsigned vertex_count,
+    size_t vertex_count,
     const unsigned* indices,
-    unsigned index_count,
+    size_t index_count,
     GLuint* vbo,
     GLuint* ibo
 ){
@@ -43,7 +61,7 @@ static inline void modelheader_gl_load_impl(
     glBindBuffer(GL_ARRAY_BUFFER, *vbo);
     glBufferData(
         GL_ARRAY_BUFFER,
-        sizeof(float)*vertex_stride*vertex_count,
+        (GLsizeiptr)(sizeof(float)*vertex_stride*vertex_count),
         vertices,
         GL_STATIC_DRAW
     );
@@ -52,14 +70,14 @@ static inline void modelheader_gl_load_impl(
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *ibo);
     glBufferData(
         GL_ELEMENT_ARRAY_BUFFER,
-        sizeof(unsigned)*index_count,
+        (GLsizeiptr)(sizeof(unsigned)*index_count),
         indices,
         GL_STATIC_DRAW
     );
 }
 
 #define modelheader_gl_load(model, vbo, ibo) \
-    modelheader_gl_load_impl( \
+    (modelheader_gl_check_index_size(model), modelheader_gl_load_impl( \
         model ## _vertices, \
         model ## _vertex_stride, \
         model ## _vertex_count, \
@@ -67,7 +85,7 @@ static inline void modelheader_gl_load_impl(
         model ## _index_count, \
         vbo, \
         ibo \
-    )
+    ))
 
 static inline void modelheader_gl_set_vertex_attribs_impl(
     unsigned vertex_stride,
@@ -125,14 +143,78 @@ static inline void modelheader_gl_set_vertex_attribs_impl(
         locations \
     )
 
+static inline void modelheader_gl_load_skin_impl(
+    const unsigned char* skin,
+    unsigned skin_stride,
+    size_t vertex_count,
+    GLuint* skin_vbo
+){
+    glGenBuffers(1, skin_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, *skin_vbo);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        (GLsizeiptr)(skin_stride*vertex_count),
+        skin,
+        GL_STATIC_DRAW
+    );
+}
+
+#define modelheader_gl_load_skin(model, skin_vbo) \
+    modelheader_gl_load_skin_impl( \
+        model ## _skin, \
+        model ## _skin_stride, \
+        model ## _vertex_count, \
+        skin_vbo \
+    )
+
+/* Joint indices are passed as unnormalized unsigned bytes, so they arrive as
+ * floats in the shader. Weights are normalized to [0, 1]. The skin VBO must be
+ * bound to GL_ARRAY_BUFFER.
+ */
+static inline void modelheader_gl_set_skin_attribs_impl(
+    unsigned skin_stride,
+    int joints_offset,
+    int weights_offset,
+    GLuint joints_location,
+    GLuint weights_location
+){
+    glVertexAttribPointer(
+        joints_location,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_FALSE,
+        skin_stride,
+        (const GLvoid*)(long long)joints_offset
+    );
+    glEnableVertexAttribArray(joints_location);
+    glVertexAttribPointer(
+        weights_location,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        skin_stride,
+        (const GLvoid*)(long long)weights_offset
+    );
+    glEnableVertexAttribArray(weights_location);
+}
+
+#define modelheader_gl_set_skin_attribs(model, joints_loc, weights_loc) \
+    modelheader_gl_set_skin_attribs_impl( \
+        model ## _skin_stride, \
+        model ## _joints_offset, \
+        model ## _weights_offset, \
+        joints_loc, \
+        weights_loc \
+    )
+
 #ifndef MODELHEADER_DISABLE_VAO
 
 static inline void modelheader_gl_load_vao_impl(
     const float* vertices,
     unsigned vertex_stride,
-    unsigned vertex_count,
+    size_t vertex_count,
     const unsigned* indices,
-    unsigned index_count,
+    size_t index_count,
     int position_offset,
     int normal_offset,
     int uv0_offset,
@@ -166,7 +248,7 @@ static inline void modelheader_gl_load_vao_impl(
 }
 
 #define modelheader_gl_load_vao(model, vbo, ibo, vao, locations) \
-    modelheader_gl_load_vao_impl( \
+    (modelheader_gl_check_index_size(model), modelheader_gl_load_vao_impl( \
         model ## _vertices, \
         model ## _vertex_stride, \
         model ## _vertex_count, \
@@ -179,7 +261,7 @@ static inline void modelheader_gl_load_vao_impl(
         ibo, \
         vao, \
         locations \
-    )
+    ))
 #endif
 
 #endif
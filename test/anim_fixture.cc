@@ -0,0 +1,140 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/* Exports the tracks of anim_tracks.h as the models anim_tight and anim_loose
+ * into the header given on the command line.
+ */
+#include "modelheader_generator.hh"
+#include "anim_tracks.h"
+#include <assimp/scene.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+aiScene* make_scene()
+{
+    using namespace anim_tracks;
+
+    aiScene* scene = new aiScene;
+    scene->mNumMaterials = 1;
+    scene->mMaterials = new aiMaterial*[1]{new aiMaterial};
+
+    aiMesh* mesh = new aiMesh;
+    mesh->mName.Set("triangle");
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    mesh->mNumVertices = 3;
+    mesh->mVertices = new aiVector3D[3]{
+        aiVector3D(0, 0, 0), aiVector3D(1, 0, 0), aiVector3D(0, 1, 0)
+    };
+    mesh->mNumFaces = 1;
+    mesh->mFaces = new aiFace[1];
+    mesh->mFaces[0].mNumIndices = 3;
+    mesh->mFaces[0].mIndices = new unsigned[3]{0, 1, 2};
+    scene->mNumMeshes = 1;
+    scene->mMeshes = new aiMesh*[1]{mesh};
+
+    /* Node i + 1 is animated by track i */
+    aiNode* root = new aiNode;
+    root->mName.Set("root");
+    root->mNumMeshes = 1;
+    root->mMeshes = new unsigned[1]{0};
+    root->mNumChildren = track_count;
+    root->mChildren = new aiNode*[track_count];
+
+    aiAnimation* anim = new aiAnimation;
+    anim->mName.Set("tracks");
+    anim->mTicksPerSecond = 1.0;
+    anim->mDuration = key_time(key_count - 1);
+    anim->mNumChannels = track_count;
+    anim->mChannels = new aiNodeAnim*[track_count];
+
+    for(unsigned i = 0; i < track_count; ++i)
+    {
+        aiNode* node = new aiNode;
+        node->mName.Set("track" + std::to_string(i));
+        node->mParent = root;
+        root->mChildren[i] = node;
+
+        aiNodeAnim* channel = new aiNodeAnim;
+        channel->mNodeName = node->mName;
+        channel->mNumPositionKeys = key_count;
+        channel->mNumRotationKeys = key_count;
+        channel->mNumScalingKeys = key_count;
+        channel->mPositionKeys = new aiVectorKey[key_count];
+        channel->mRotationKeys = new aiQuatKey[key_count];
+        channel->mScalingKeys = new aiVectorKey[key_count];
+        for(unsigned k = 0; k < key_count; ++k)
+        {
+            double p[3], q[4], s[3];
+            position(i, k, p);
+            rotation(i, k, q);
+            scaling(i, k, s);
+            channel->mPositionKeys[k].mTime = key_time(k);
+            channel->mPositionKeys[k].mValue = aiVector3D(p[0], p[1], p[2]);
+            channel->mRotationKeys[k].mTime = key_time(k);
+            channel->mRotationKeys[k].mValue = aiQuaternion(
+                q[3], q[0], q[1], q[2]
+            );
+            channel->mScalingKeys[k].mTime = key_time(k);
+            channel->mScalingKeys[k].mValue = aiVector3D(s[0], s[1], s[2]);
+        }
+        anim->mChannels[i] = channel;
+    }
+
+    scene->mNumAnimations = 1;
+    scene->mAnimations = new aiAnimation*[1]{anim};
+    scene->mRootNode = root;
+    return scene;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if(argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " output_header" << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(argv[1]);
+    aiScene* scene = make_scene();
+
+    modelheader::options options;
+    options.source_name = "anim_tracks.h";
+    options.animations = true;
+
+    options.name_prefix = "anim_tight";
+    options.anim_tolerance = anim_tracks::tight_tolerance;
+    bool ok = modelheader::convert(options, scene, out);
+
+    options.name_prefix = "anim_loose";
+    options.anim_tolerance = anim_tracks::loose_tolerance;
+    ok = ok && modelheader::convert(options, scene, out);
+
+    delete scene;
+    return ok && out ? 0 : 1;
+}
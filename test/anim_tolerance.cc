@@ -0,0 +1,144 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/* Samples every reduced and quantized channel of the models written by
+ * anim_fixture at the original key times, and fails if any of them is
+ * further than the animation tolerance from the original keys.
+ */
+#include "anim_test_model.h"
+#include "modelheader_anim.h"
+#include "anim_tracks.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+
+double vector_distance(const float* a, const double* b)
+{
+    double sum = 0;
+    for(unsigned i = 0; i < 3; ++i) sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return sqrt(sum);
+}
+
+/* Angle of the rotation between two unit quaternions given as x, y, z, w */
+double rotation_angle(const float* a, const double* b)
+{
+    double dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+    double cross[3] = {
+        b[3]*a[0] - a[3]*b[0] - (a[1]*b[2] - a[2]*b[1]),
+        b[3]*a[1] - a[3]*b[1] - (a[2]*b[0] - a[0]*b[2]),
+        b[3]*a[2] - a[3]*b[2] - (a[0]*b[1] - a[1]*b[0])
+    };
+    double len = sqrt(
+        cross[0]*cross[0] + cross[1]*cross[1] + cross[2]*cross[2]
+    );
+    return 2.0 * atan2(len, fabs(dot));
+}
+
+bool check(
+    const char* name,
+    const modelheader_animation& animation,
+    double tolerance
+){
+    using namespace anim_tracks;
+
+    bool ok = animation.channel_count == track_count;
+    for(unsigned i = 0; i < animation.channel_count; ++i)
+    {
+        const modelheader_channel& c = animation.channels[i];
+        unsigned track = c.node - 1;
+        double position_error = 0;
+        double rotation_error = 0;
+        double scaling_error = 0;
+
+        for(unsigned k = 0; k < key_count; ++k)
+        {
+            float time = key_time(k);
+            double expected[4];
+            float sampled[4];
+
+            position(track, k, expected);
+            modelheader_sample_vector(
+                c.position_times, c.positions, c.position_count,
+                c.position_bias, c.position_scale, time, sampled
+            );
+            position_error = std::max(
+                position_error, vector_distance(sampled, expected)
+            );
+
+            rotation(track, k, expected);
+            modelheader_sample_rotation(
+                c.rotation_times, c.rotations, c.rotation_count, time, sampled
+            );
+            rotation_error = std::max(
+                rotation_error, rotation_angle(sampled, expected)
+            );
+
+            scaling(track, k, expected);
+            modelheader_sample_vector(
+                c.scaling_times, c.scalings, c.scaling_count,
+                c.scaling_bias, c.scaling_scale, time, sampled
+            );
+            scaling_error = std::max(
+                scaling_error, vector_distance(sampled, expected)
+            );
+        }
+
+        bool track_ok =
+            position_error <= tolerance &&
+            rotation_error <= tolerance &&
+            scaling_error <= tolerance;
+        ok &= track_ok;
+
+        printf(
+            "%s track %u: keys %u/%u/%u, error %g/%g/%g%s\n",
+            name, track, c.position_count, c.rotation_count,
+            c.scaling_count, position_error, rotation_error, scaling_error,
+            track_ok ? "" : " EXCEEDS TOLERANCE"
+        );
+    }
+    return ok;
+}
+
+}
+
+int main()
+{
+    bool ok = check(
+        "anim_tight", anim_tight_animations[0], anim_tracks::tight_tolerance
+    );
+    ok &= check(
+        "anim_loose", anim_loose_animations[0], anim_tracks::loose_tolerance
+    );
+
+    /* A constant-speed rotation is exactly what key reduction should remove */
+    const modelheader_channel& linear = anim_tight_animations[0].channels[1];
+    if(linear.rotation_count > anim_tracks::key_count / 4)
+    {
+        printf("Constant-speed rotation was not reduced.\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2018 Julius Ikkala
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/* Synthetic animation tracks, shared by the fixture that exports them and the
+ * test that samples the exported model back.
+ */
+#ifndef MODELHEADER_TEST_ANIM_TRACKS_H
+#define MODELHEADER_TEST_ANIM_TRACKS_H
+#include <cmath>
+
+namespace anim_tracks
+{
+
+const double pi = 3.14159265358979323846;
+const unsigned key_count = 61;
+const double key_interval = 0.05;
+const unsigned track_count = 4;
+
+/* Each track is exported once per tolerance, as models anim_tight and
+ * anim_loose.
+ */
+const double tight_tolerance = 0.001;
+const double loose_tolerance = 0.01;
+
+inline double key_time(unsigned k)
+{
+    return k * key_interval;
+}
+
+/* Rotation by angle around the normalized axis, as x, y, z, w */
+inline void axis_angle(double x, double y, double z, double angle, double* q)
+{
+    double len = sqrt(x*x + y*y + z*z);
+    double s = sin(angle * 0.5) / len;
+    q[0] = x * s;
+    q[1] = y * s;
+    q[2] = z * s;
+    q[3] = cos(angle * 0.5);
+}
+
+inline void position(unsigned track, unsigned k, double* p)
+{
+    double t = key_time(k);
+    switch(track)
+    {
+    case 0: /* Constant, far from the origin */
+        p[0] = 1234.5678; p[1] = -0.000123; p[2] = 42.4242;
+        break;
+    case 1: /* Linear */
+        p[0] = 10.0 * t; p[1] = 0.5; p[2] = -2.0 * t;
+        break;
+    case 2: /* Curved */
+        p[0] = 20.0 * sin(t); p[1] = 5.0 * cos(0.7 * t); p[2] = 0.5;
+        break;
+    default: /* Small curve */
+        p[0] = 0.1 * sin(3.0 * t); p[1] = 0.1 * t * t; p[2] = 0.0;
+        break;
+    }
+}
+
+inline void rotation(unsigned track, unsigned k, double* q)
+{
+    double f = k / (double)(key_count - 1);
+    switch(track)
+    {
+    case 0: /* 160 degrees at constant speed */
+        axis_angle(1, 2, 3, f * 160.0 * pi / 180.0, q);
+        break;
+    case 1: /* 30 degrees at constant speed */
+        axis_angle(0, 1, 0, f * 30.0 * pi / 180.0, q);
+        break;
+    case 2: /* Varying speed */
+        axis_angle(1, 0, 1, sin(f * 6.0) * 1.2, q);
+        break;
+    default: /* Two full turns */
+        axis_angle(0, 0, 1, f * 4.0 * pi, q);
+        break;
+    }
+}
+
+inline void scaling(unsigned track, unsigned k, double* s)
+{
+    double t = key_time(k);
+    switch(track)
+    {
+    case 1:
+        s[0] = s[1] = s[2] = 1.0 + t;
+        break;
+    case 2:
+        s[0] = 1.0 + 0.5 * sin(t); s[1] = 1.0; s[2] = 2.0 - 0.25 * t;
+        break;
+    default:
+        s[0] = s[1] = s[2] = 1.0;
+        break;
+    }
+}
+
+}
+
+#endif